@@ -0,0 +1,87 @@
+/**
+ * @file activation_depth.cpp
+ *
+ * @brief Checks ActivationFunction::getDepth against the levels that OpenFHE actually consumes. For every degree at
+ * the boundaries of the depth table a context with exactly getDepth levels is created, a ReLU of that degree is
+ * evaluated and the levels of the result are compared to those of the input. Exits with 1 if an activation does not
+ * fit into the depth it reports, since Application::placeBootstraps would then place the bootstraps too late.
+ *
+ * Usage: NeuralOFHE_activation_depth [maxDegree]
+ *
+ */
+
+#include <iomanip>
+#include <iostream>
+
+#include "NeuralOFHE/NeuralOFHE.h"
+
+
+/***
+ * Levels that a ciphertext has used up, including a pending rescale of a product that was not rescaled yet.
+ */
+static uint32_t consumed_levels(const Ciphertext<DCRTPoly>& x) {
+    return x->GetLevel() + x->GetNoiseScaleDeg() - 1;
+}
+
+
+int main(int argc, char* argv[]) {
+    uint32_t maxDegree = argc > 1 ? std::stoul(argv[1]) : 119;
+
+    std::cout << std::setw(8) << "degree" << std::setw(10) << "getDepth" << std::setw(10) << "consumed" << std::endl;
+
+    bool failed = false;
+    for (uint32_t degree : {3u, 5u, 6u, 13u, 14u, 27u, 28u, 59u, 60u, 119u, 120u, 247u}) {
+        if (degree > maxDegree)
+            break;
+
+        //  The depth only depends on the degree, so it can be read off an activation before the context exists
+        uint32_t depth = nn::ReLU(-1, 1, degree).getDepth();
+
+        CCParams<CryptoContextCKKSRNS> parameters;
+        parameters.SetMultiplicativeDepth(depth);
+        parameters.SetScalingModSize(40);
+        parameters.SetFirstModSize(50);
+        parameters.SetBatchSize(16);
+        parameters.SetRingDim(1 << 10);
+        parameters.SetSecurityLevel(HEStd_NotSet);
+        parameters.SetScalingTechnique(FLEXIBLEAUTO);
+
+        CryptoContext<DCRTPoly> context = GenCryptoContext(parameters);
+        context->Enable(PKE);
+        context->Enable(KEYSWITCH);
+        context->Enable(LEVELEDSHE);
+        context->Enable(ADVANCEDSHE);
+        SetContext(context);
+
+        auto keys = context->KeyGen();
+        context->EvalMultKeyGen(keys.secretKey);
+
+        std::vector<double> input(16);
+        for (size_t i = 0; i < input.size(); i++)
+            input[i] = -1. + 2. * i / (input.size() - 1);
+
+        auto x = context->Encrypt(keys.publicKey, context->MakeCKKSPackedPlaintext(input));
+
+        nn::ReLU relu(-1, 1, degree);
+        uint32_t consumed;
+        try {
+            consumed = consumed_levels(relu.forward(x)) - consumed_levels(x);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Degree " << degree << " does not fit into a depth of " << depth << ": " << e.what()
+                      << std::endl;
+            failed = true;
+            continue;
+        }
+
+        std::cout << std::setw(8) << degree << std::setw(10) << depth << std::setw(10) << consumed << std::endl;
+
+        if (consumed > depth) {
+            std::cerr << "Degree " << degree << " consumes " << consumed << " levels, but getDepth reports " << depth
+                      << std::endl;
+            failed = true;
+        }
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file batch_throughput.cpp
+ *
+ * @brief Measures the throughput of Application::forwardBatch in requests per second for an increasing number of
+ * cores, compared to running the requests one after another with forward. Uses a small model and small, insecure
+ * parameters.
+ *
+ * Usage: NeuralOFHE_batch_throughput [batchSize] [requests]
+ *
+ */
+
+#include <chrono>
+#include <random>
+#include <iomanip>
+
+#include "NeuralOFHE/NeuralOFHE.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+/***
+ * Random tensor of shape rows x columns with entries in [-1, 1].
+ */
+static Tensor random_tensor(size_t rows, size_t columns, std::mt19937& generator) {
+    std::uniform_real_distribution<double> value(-1., 1.);
+
+    std::vector<double> values(rows * columns);
+    for (auto& entry : values)
+        entry = value(generator) / std::sqrt(rows);
+
+    return Tensor({rows, columns}, std::move(values));
+}
+
+
+int main(int argc, char* argv[]) {
+    uint32_t batchSize = argc > 1 ? std::stoul(argv[1]) : 1024;
+    uint32_t requests = argc > 2 ? std::stoul(argv[2]) : 16;
+
+    CCParams<CryptoContextCKKSRNS> parameters;
+    parameters.SetMultiplicativeDepth(3);
+    parameters.SetScalingModSize(40);
+    parameters.SetFirstModSize(50);
+    parameters.SetBatchSize(batchSize);
+    parameters.SetRingDim(2 * batchSize);
+    parameters.SetSecurityLevel(HEStd_NotSet);
+
+    CryptoContext<DCRTPoly> context = GenCryptoContext(parameters);
+    context->Enable(PKE);
+    context->Enable(KEYSWITCH);
+    context->Enable(LEVELEDSHE);
+    SetContext(context);
+
+    std::mt19937 generator(42);
+
+    //  Gemm -> Square -> Gemm, whose last layer has too few outputs to keep many cores busy on its own
+    std::vector<std::shared_ptr<Operator>> layers = {
+            std::make_shared<nn::Gemm>(random_tensor(batchSize, 64, generator), std::vector<double>(64, .0)),
+            std::make_shared<nn::Square>(),
+            std::make_shared<nn::Gemm>(random_tensor(64, 10, generator), std::vector<double>(10, .0))
+    };
+    Application app(layers);
+
+    auto keys = context->KeyGen();
+    context->EvalMultKeyGen(keys.secretKey);
+    context->EvalRotateKeyGen(keys.secretKey, app.getRotationIndices());
+
+    std::uniform_real_distribution<double> value(-1., 1.);
+    std::vector<Ciphertext<DCRTPoly>> inputs;
+    for (uint32_t i = 0; i < requests; i++) {
+        std::vector<double> input(batchSize);
+        for (auto& entry : input)
+            entry = value(generator);
+
+        inputs.push_back(context->Encrypt(keys.publicKey, context->MakeCKKSPackedPlaintext(input)));
+    }
+
+    //  Warm-up pass, which fills the plaintext caches of the layers
+    app.forward(inputs.front());
+
+    std::cout << "Batch size " << batchSize << ", " << requests << " requests" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& input : inputs)
+        app.forward(input);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    double sequential = requests / elapsed.count();
+    std::cout << "sequential forward: " << std::fixed << std::setprecision(2) << sequential << " req/s" << std::endl;
+
+    #ifdef _OPENMP
+    int maxThreads = omp_get_max_threads();
+    #else
+    int maxThreads = 1;
+    #endif
+
+    std::cout << std::setw(8) << "cores" << std::setw(14) << "req/s" << std::setw(10) << "speedup" << std::endl;
+
+    for (int threads = 1; threads <= maxThreads; threads = threads * 2 > maxThreads && threads != maxThreads ? maxThreads : threads * 2) {
+        start = std::chrono::steady_clock::now();
+        app.forwardBatch(inputs, threads);
+        elapsed = std::chrono::steady_clock::now() - start;
+
+        double throughput = requests / elapsed.count();
+        std::cout << std::setw(8) << threads << std::setw(14) << throughput << std::setw(10) << throughput / sequential
+                  << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,281 @@
+/**
+ * @file kernels_bench.cpp
+ *
+ * @brief Google benchmark suite of the NeuralOFHE kernels: the sequential and parallel matrix multiplication, the
+ * Chebyshev activations, BatchNorm and BootStrapping, parameterized over batch sizes, ring dimensions, matrix
+ * densities, polynomial degrees and thread counts. Uses small, insecure parameters.
+ *
+ * Usage: NeuralOFHE_bench [--benchmark_filter=<regex>] [--benchmark_out=<file> --benchmark_out_format=json]
+ *
+ * The JSON output of two releases can be compared with compare.py of the google benchmark tools.
+ *
+ */
+
+#include <map>
+#include <random>
+#include <tuple>
+
+#include <benchmark/benchmark.h>
+
+#include "NeuralOFHE/NeuralOFHE.h"
+#include "LinTools.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+/***
+ * Context and keys of one parameter set. Rotation keys are added as benchmarks request them.
+ */
+struct Environment {
+    CryptoContext<DCRTPoly> context;
+    KeyPair<DCRTPoly> keys;
+    std::set<int> rotations;
+};
+
+
+/***
+ * Environment for the given parameters, created once and shared by all benchmarks that use the same ones, as key
+ * generation takes longer than most kernels.
+ */
+static Environment& environment(uint32_t batchSize, uint32_t ringDim, uint32_t depth, bool bootstrapping = false) {
+    static std::map<std::tuple<uint32_t, uint32_t, uint32_t, bool>, Environment> environments;
+
+    auto key = std::make_tuple(batchSize, ringDim, depth, bootstrapping);
+    auto it = environments.find(key);
+
+    if (it == environments.end()) {
+        std::vector<uint32_t> levelBudget = {1, 1};
+
+        CCParams<CryptoContextCKKSRNS> parameters;
+        parameters.SetScalingModSize(40);
+        parameters.SetFirstModSize(50);
+        parameters.SetBatchSize(batchSize);
+        parameters.SetRingDim(ringDim);
+        parameters.SetSecurityLevel(HEStd_NotSet);
+        parameters.SetScalingTechnique(FLEXIBLEAUTO);
+
+        if (bootstrapping) {
+            parameters.SetSecretKeyDist(UNIFORM_TERNARY);
+            parameters.SetMultiplicativeDepth(depth + FHECKKSRNS::GetBootstrapDepth(levelBudget, UNIFORM_TERNARY));
+        } else {
+            parameters.SetMultiplicativeDepth(depth);
+        }
+
+        Environment env;
+        env.context = GenCryptoContext(parameters);
+        env.context->Enable(PKE);
+        env.context->Enable(KEYSWITCH);
+        env.context->Enable(LEVELEDSHE);
+        env.context->Enable(ADVANCEDSHE);
+
+        if (bootstrapping) {
+            env.context->Enable(FHE);
+            env.context->EvalBootstrapSetup(levelBudget, {0, 0}, batchSize);
+        }
+
+        env.keys = env.context->KeyGen();
+        env.context->EvalMultKeyGen(env.keys.secretKey);
+
+        if (bootstrapping)
+            env.context->EvalBootstrapKeyGen(env.keys.secretKey, batchSize);
+
+        it = environments.emplace(key, std::move(env)).first;
+    }
+
+    SetContext(it->second.context);
+
+    return it->second;
+}
+
+
+/***
+ * Generates the rotation keys of the environment that are still missing.
+ */
+static void require_rotations(Environment& env, const std::vector<int>& rotations) {
+    std::vector<int> missing;
+    for (int rotation : rotations)
+        if (env.rotations.insert(rotation).second)
+            missing.push_back(rotation);
+
+    if (!missing.empty())
+        env.context->EvalRotateKeyGen(env.keys.secretKey, missing);
+}
+
+
+/***
+ * Encryption of random values in [-1, 1] in all slots.
+ */
+static Ciphertext<DCRTPoly> random_ciphertext(Environment& env, uint32_t batchSize) {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> value(-1., 1.);
+
+    std::vector<double> input(batchSize);
+    for (auto& entry : input)
+        entry = value(generator);
+
+    return env.context->Encrypt(env.keys.publicKey, env.context->MakeCKKSPackedPlaintext(input));
+}
+
+
+static void set_threads(int threads) {
+    #ifdef _OPENMP
+    omp_set_num_threads(threads);
+    #endif
+}
+
+
+static int max_threads() {
+    #ifdef _OPENMP
+    return omp_get_max_threads();
+    #else
+    return 1;
+    #endif
+}
+
+
+/***
+ * Matrix multiplication with a random square matrix of dimension min(batchSize, 512). The density is that of its
+ * diagonals, as they decide the cost: every cyclic diagonal of the matrix is non-zero with that probability.
+ *
+ * Arguments: batch size, ring dimension, density in percent, threads
+ */
+static void BM_MatMul(benchmark::State& state, bool parallel) {
+    uint32_t batchSize = state.range(0);
+    uint32_t ringDim = state.range(1);
+    double density = state.range(2) / 100.;
+    set_threads(state.range(3));
+
+    Environment& env = environment(batchSize, ringDim, 1);
+
+    uint32_t dimension = std::min<uint32_t>(batchSize, 512);
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> value(-1., 1.);
+    std::bernoulli_distribution nonZero(density);
+
+    std::vector<double> values(dimension * dimension, .0);
+    for (uint32_t t = 0; t < dimension; t++)
+        if (nonZero(generator) || t == 0)
+            for (uint32_t i = 0; i < dimension; i++)
+                values[i * dimension + (i + t) % dimension] = value(generator);
+
+    DiagonalSchedule schedule = make_diagonal_schedule(Tensor({dimension, dimension}, std::move(values)), batchSize);
+    require_rotations(env, schedule_rotations(schedule));
+
+    Ciphertext<DCRTPoly> x = random_ciphertext(env, batchSize);
+    PlaintextCache cache;
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(parallel ? matrix_multiplication_parallel(schedule, x, env.context, &cache)
+                                          : matrix_multiplication_sequential(schedule, x, env.context, &cache));
+
+    state.counters["diagonals"] = schedule.diagonals.size();
+    state.counters["giantSteps"] = schedule.giantSteps.size();
+}
+
+
+/***
+ * Chebyshev approximation of ReLU of the given degree.
+ *
+ * Arguments: polynomial degree, threads
+ */
+static void BM_ReLU(benchmark::State& state) {
+    uint32_t degree = state.range(0);
+    set_threads(state.range(1));
+
+    //  The depth of the activation only depends on its degree, so a throwaway context is enough to get it
+    environment(1024, 2048, 1);
+    uint32_t depth = nn::ReLU(-1, 1, degree).getDepth();
+
+    Environment& env = environment(1024, 2048, depth);
+    nn::ReLU relu(-1, 1, degree);
+    Ciphertext<DCRTPoly> x = random_ciphertext(env, 1024);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(relu.forward(x));
+
+    state.counters["depth"] = depth;
+}
+
+
+/***
+ * BatchNorm, i.e. one plaintext multiplication and addition.
+ *
+ * Arguments: batch size
+ */
+static void BM_BatchNorm(benchmark::State& state) {
+    uint32_t batchSize = state.range(0);
+
+    Environment& env = environment(batchSize, 2 * batchSize, 1);
+    nn::BatchNorm batchNorm(std::vector<double>(batchSize, .5), std::vector<double>(batchSize, .1));
+    Ciphertext<DCRTPoly> x = random_ciphertext(env, batchSize);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(batchNorm.forward(x));
+}
+
+
+/***
+ * Bootstrapping of a ciphertext on its last level.
+ *
+ * Arguments: slots, ring dimension
+ */
+static void BM_BootStrapping(benchmark::State& state) {
+    uint32_t slots = state.range(0);
+    uint32_t ringDim = state.range(1);
+
+    Environment& env = environment(slots, ringDim, 1, true);
+    BootStrapping bootstrapping;
+
+    Ciphertext<DCRTPoly> x = random_ciphertext(env, slots);
+    x = env.context->EvalMult(x, 1.);
+    env.context->RescaleInPlace(x);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(bootstrapping.forward(x));
+}
+
+
+/***
+ * Batch sizes from 256 to 16384, each with the smallest ring dimension that fits it and the next larger one.
+ */
+static void matmul_arguments(benchmark::internal::Benchmark* benchmark) {
+    for (int64_t batchSize = 256; batchSize <= 16384; batchSize *= 4)
+        for (int64_t ringDim : {2 * batchSize, 4 * batchSize})
+            for (int64_t density : {10, 100})
+                for (int64_t threads : {1, max_threads()}) {
+                    benchmark->Args({batchSize, ringDim, density, threads});
+                    if (max_threads() == 1)
+                        break;
+                }
+}
+
+
+static void thread_arguments(benchmark::internal::Benchmark* benchmark) {
+    for (int64_t degree : {5, 13, 27, 59, 119})
+        for (int64_t threads : {1, max_threads()}) {
+            benchmark->Args({degree, threads});
+            if (max_threads() == 1)
+                break;
+        }
+}
+
+
+BENCHMARK_CAPTURE(BM_MatMul, sequential, false)
+        ->Apply(matmul_arguments)->ArgNames({"batch", "ring", "density", "threads"})
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_MatMul, parallel, true)
+        ->Apply(matmul_arguments)->ArgNames({"batch", "ring", "density", "threads"})
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_ReLU)
+        ->Apply(thread_arguments)->ArgNames({"degree", "threads"})
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_BatchNorm)
+        ->RangeMultiplier(4)->Range(256, 16384)->ArgName("batch")
+        ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_BootStrapping)
+        ->Args({8, 4096})->Args({2048, 4096})->ArgNames({"slots", "ring"})
+        ->Unit(benchmark::kMillisecond)->Iterations(3)->UseRealTime();
+
+BENCHMARK_MAIN();
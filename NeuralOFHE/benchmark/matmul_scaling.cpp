@@ -0,0 +1,121 @@
+/**
+ * @file matmul_scaling.cpp
+ *
+ * @brief Measures the speedup of matrix_multiplication_parallel over one thread for an increasing number of OpenMP
+ * threads. Uses small, insecure parameters.
+ *
+ * Usage: NeuralOFHE_matmul_scaling [batchSize] [density] [repetitions]
+ *
+ */
+
+#include <chrono>
+#include <random>
+#include <iomanip>
+
+#include "NeuralOFHE/NeuralOFHE.h"
+#include "LinTools.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+/***
+ * Random matrix of shape size x size in which every entry is non-zero with the given probability.
+ */
+static matVec random_matrix(uint32_t size, double density, std::mt19937& generator) {
+    std::uniform_real_distribution<double> value(-1., 1.);
+    std::bernoulli_distribution nonZero(density);
+
+    matVec matrix(size, std::vector<double>(size, .0));
+    for (auto& row : matrix)
+        for (auto& entry : row)
+            if (nonZero(generator))
+                entry = value(generator);
+
+    return matrix;
+}
+
+
+/***
+ * Average wall time of one matrix multiplication in milliseconds.
+ */
+static double time_multiplication(const DiagonalSchedule& schedule, const Ciphertext<DCRTPoly>& x,
+                                  CryptoContext<DCRTPoly> context, bool parallel, uint32_t repetitions,
+                                  MatMulEngine engine = MatMulEngine::HOISTED) {
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t i=0; i<repetitions; i++)
+        matrix_multiplication(schedule, x, context, parallel, nullptr, engine);
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    return elapsed.count() / repetitions;
+}
+
+
+int main(int argc, char* argv[]) {
+    uint32_t batchSize = argc > 1 ? std::stoul(argv[1]) : 1024;
+    double density = argc > 2 ? std::stod(argv[2]) : 1.;
+    uint32_t repetitions = argc > 3 ? std::stoul(argv[3]) : 3;
+
+    CCParams<CryptoContextCKKSRNS> parameters;
+    parameters.SetMultiplicativeDepth(2);
+    parameters.SetScalingModSize(40);
+    parameters.SetFirstModSize(50);
+    parameters.SetBatchSize(batchSize);
+    parameters.SetRingDim(2 * batchSize);
+    parameters.SetSecurityLevel(HEStd_NotSet);
+
+    CryptoContext<DCRTPoly> context = GenCryptoContext(parameters);
+    context->Enable(PKE);
+    context->Enable(KEYSWITCH);
+    context->Enable(LEVELEDSHE);
+
+    auto keys = context->KeyGen();
+    context->EvalRotateKeyGen(keys.secretKey, GetRotations(batchSize));
+    SetContext(context);
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> value(-1., 1.);
+
+    std::vector<double> input(batchSize);
+    for (auto& entry : input)
+        entry = value(generator);
+
+    Ciphertext<DCRTPoly> x = context->Encrypt(keys.publicKey, context->MakeCKKSPackedPlaintext(input));
+    DiagonalSchedule schedule = make_diagonal_schedule(random_matrix(batchSize, density, generator), batchSize);
+
+    std::cout << "Batch size " << batchSize << ", density " << density << ", " << schedule.diagonals.size()
+              << " diagonals in " << schedule.giantSteps.size() << " giant steps" << std::endl;
+
+    double sequential = time_multiplication(schedule, x, context, false, repetitions);
+    std::cout << "sequential: " << std::fixed << std::setprecision(1) << sequential << " ms" << std::endl;
+
+    double doubleHoisted = time_multiplication(schedule, x, context, false, repetitions, MatMulEngine::DOUBLE_HOISTED);
+    std::cout << "sequential, double hoisted: " << doubleHoisted << " ms" << std::endl;
+
+    #ifdef _OPENMP
+    int maxThreads = omp_get_max_threads();
+    #else
+    int maxThreads = 1;
+    #endif
+
+    double single = 0;
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "time [ms]" << std::setw(10) << "speedup" << std::endl;
+
+    for (int threads = 1; threads <= maxThreads; threads = threads * 2 > maxThreads && threads != maxThreads ? maxThreads : threads * 2) {
+        #ifdef _OPENMP
+        omp_set_num_threads(threads);
+        #endif
+
+        double elapsed = time_multiplication(schedule, x, context, true, repetitions);
+        if (threads == 1)
+            single = elapsed;
+
+        std::cout << std::setw(8) << threads << std::setw(14) << elapsed << std::setw(10) << std::setprecision(2)
+                  << single / elapsed << std::setprecision(1) << std::endl;
+    }
+
+    return 0;
+}
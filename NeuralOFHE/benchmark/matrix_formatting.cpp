@@ -0,0 +1,165 @@
+/**
+ * @file matrix_formatting.cpp
+ *
+ * @brief Compares the cache-blocked, parallel plaintext matrix formatting against the straightforward implementations
+ * it replaced, for batch sizes of 1024, 4096 and 16384 slots. No cryptocontext is needed.
+ *
+ * Usage: NeuralOFHE_matrix_formatting [dimension] [repetitions]
+ *
+ * The matrices are of shape dimension x dimension, by default a quarter of the batch size, since a dense matrix has
+ * 2 * dimension - 1 diagonals of batch size slots each.
+ *
+ */
+
+#include <chrono>
+#include <random>
+#include <iomanip>
+#include <iostream>
+#include <functional>
+
+#include "MatrixFormatting.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+/***
+ * banded_diagonals before blocking: one map lookup per non-zero entry, walking the matrix row by row.
+ */
+static std::map<unsigned int, std::vector<double>> reference_banded(const Tensor& matrix, uint32_t batchSize) {
+    std::map<unsigned int, std::vector<double>> result;
+
+    for (unsigned int c=0; c<matrix.rows(); c++) {
+        const double* column = matrix.row(c);
+
+        for (unsigned int r=0; r<matrix.cols(); r++) {
+            if (column[r] == .0)
+                continue;
+
+            auto& diagonal = result[(c + batchSize - r) % batchSize];
+            if (diagonal.empty())
+                diagonal.resize(batchSize, .0);
+
+            diagonal[r] = column[r];
+        }
+    }
+
+    return result;
+}
+
+
+/***
+ * diagonal_transformation before blocking: every result row reads one entry of every row of the matrix.
+ */
+static matVec reference_diagonal_transformation(const matVec& matrix) {
+    matVec result;
+
+    for (unsigned int i=0; i< matrix.size(); i++) {
+        std::vector<double> row;
+        for (unsigned int j = 0; j < matrix[0].size(); j++)
+            row.push_back(matrix[j % matrix.size()][(j + i) % matrix[0].size()]);
+        result.push_back(row);
+    }
+
+    return result;
+}
+
+
+/***
+ * transpose before blocking: the result is written row by row and the matrix is read column by column.
+ */
+static matVec reference_transpose(const matVec& matrix) {
+    matVec result(matrix[0].size(), std::vector<double>(matrix.size()));
+
+    for(unsigned int i=0; i<matrix[0].size(); i++)
+        for (unsigned int j=0; j<matrix.size(); j++)
+            result[i][j] = matrix[j][i];
+
+    return result;
+}
+
+
+/***
+ * Smallest wall time of the given function over all repetitions in milliseconds.
+ */
+static double time_call(const std::function<void()>& function, uint32_t repetitions) {
+    double best = 0;
+
+    for (uint32_t i=0; i<repetitions; i++) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (i == 0 || elapsed.count() < best)
+            best = elapsed.count();
+    }
+
+    return best;
+}
+
+
+static void print_row(const std::string& name, double reference, double blocked, bool equal) {
+    std::cout << std::setw(26) << name << std::setw(14) << reference << std::setw(14) << blocked << std::setw(10)
+              << std::setprecision(2) << reference / blocked << std::setprecision(1)
+              << (equal ? "" : "  MISMATCH") << std::endl;
+}
+
+
+int main(int argc, char* argv[]) {
+    uint32_t dimension = argc > 1 ? std::stoul(argv[1]) : 0;
+    uint32_t repetitions = argc > 2 ? std::stoul(argv[2]) : 3;
+
+    #ifdef _OPENMP
+    std::cout << omp_get_max_threads() << " OpenMP threads" << std::endl;
+    #endif
+
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> value(-1., 1.);
+
+    std::cout << std::fixed << std::setprecision(1);
+
+    for (uint32_t batchSize : {1024u, 4096u, 16384u}) {
+        uint32_t size = dimension ? std::min(dimension, batchSize) : batchSize / 4;
+
+        matVec rows(size, std::vector<double>(size));
+        for (auto& row : rows)
+            for (auto& entry : row)
+                entry = value(generator);
+        Tensor matrix(rows);
+
+        std::cout << std::endl << "Batch size " << batchSize << ", matrix " << size << "x" << size << std::endl;
+        std::cout << std::setw(26) << "" << std::setw(14) << "before [ms]" << std::setw(14) << "after [ms]"
+                  << std::setw(10) << "speedup" << std::endl;
+
+        bool equal;
+        double reference, blocked;
+
+        {
+            std::map<unsigned int, std::vector<double>> before, after;
+            reference = time_call([&]() { before = reference_banded(matrix, batchSize); }, repetitions);
+            before.clear();
+            blocked = time_call([&]() { after = banded_diagonals(matrix, batchSize); }, repetitions);
+            equal = after == reference_banded(matrix, batchSize);
+        }
+        print_row("banded_diagonals", reference, blocked, equal);
+
+        {
+            matVec before, after;
+            reference = time_call([&]() { before = reference_diagonal_transformation(rows); }, repetitions);
+            blocked = time_call([&]() { after = diagonal_transformation(rows); }, repetitions);
+            equal = before == after;
+        }
+        print_row("diagonal_transformation", reference, blocked, equal);
+
+        {
+            matVec before, after;
+            reference = time_call([&]() { before = reference_transpose(rows); }, repetitions);
+            blocked = time_call([&]() { after = transpose(rows); }, repetitions);
+            equal = before == after;
+        }
+        print_row("transpose", reference, blocked, equal);
+    }
+
+    return 0;
+}
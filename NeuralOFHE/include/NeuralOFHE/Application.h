@@ -3,19 +3,164 @@
 
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <string>
 
 #include "Operators/InherOperators.h"
+#include "Graph.h"
+
+
+/***
+ * Work-stealing thread pool of forwardBatch. Defined in src/ThreadPool.h.
+ */
+class ThreadPool;
+
+
+/***
+ * Placement of bootstraps in the layers of an application, see Application::placeBootstraps.
+ */
+struct BootstrapPlan {
+    /***
+     * Indices of the layers, in the order before placement, in front of which a bootstrap was inserted.
+     */
+    std::vector<size_t> positions;
+
+    /***
+     * Names, depths and levels left after every layer of the planned application, including the bootstraps.
+     */
+    std::vector<std::string> names;
+    std::vector<uint32_t> depths;
+    std::vector<uint32_t> levelsLeft;
+
+    /***
+     * Number of bootstraps, including those that were part of the layers already.
+     */
+    uint32_t bootstraps = 0;
+
+    /***
+     * Returns a table of the planned layers with their depth and the levels left after them.
+     */
+    std::string report() const;
+};
 
 
 class Application {
 public:
-    Application(const std::vector<std::shared_ptr<Operator>>& layers);
+    /***
+     * Constructor of an application that applies the layers one after another.
+     *
+     * @param layers Operators in the order of the forward pass
+     * @param fold Whether adjacent affine layers are folded together, see fold
+     */
+    Application(const std::vector<std::shared_ptr<Operator>>& layers, bool fold = true);
+
+    /***
+     * Constructor of an application that evaluates a graph of operators with a single input and output, e.g. a model
+     * with residual connections. fold and placeBootstraps only apply to chains of layers.
+     *
+     * @param graph Graph of the model
+     */
+    Application(std::shared_ptr<Graph> graph);
 
     Ciphertext<DCRTPoly> forward(Ciphertext<DCRTPoly> x);
 
+    /***
+     * Runs the forward passes of several independent requests concurrently on a work-stealing thread pool.
+     *
+     * The cores are split between the requests and the OpenMP regions within them: with w = min(threads, number of
+     * requests) workers, every request runs its OpenMP loops with threads / w threads, so that both levels of
+     * parallelism together never use more threads than cores. Small layers, e.g. a Gemm with 10 outputs, keep all
+     * cores busy that way, while a single request still gets all of them.
+     *
+     * @param inputs Input ciphertexts of the requests
+     * @param threads Number of cores to use, the number of OpenMP threads if 0
+     * @return Output ciphertexts in the order of the inputs
+     */
+    std::vector<Ciphertext<DCRTPoly>> forwardBatch(const std::vector<Ciphertext<DCRTPoly>>& inputs,
+                                                   uint32_t threads = 0);
+
+    /***
+     * Collects the rotation indices that a forward pass through all layers requests.
+     *
+     * @return Rotation indices in ascending order
+     */
+    std::vector<int> getRotationIndices();
+
+    /***
+     * Getter for the layers after folding.
+     *
+     * @return Layers in the order of the forward pass
+     */
+    std::vector<std::shared_ptr<Operator>> getLayers();
+
+    /***
+     * Checks whether the application was built from a graph, whose layers are not a linear chain.
+     *
+     * @return True if the application evaluates a Graph
+     */
+    bool isGraph();
+
+    /***
+     * Getter for the profiles of the layers, which are recorded while profiling is enabled, see Profiler::setEnabled.
+     *
+     * @return Profiles of the layers in the order of the forward pass
+     */
+    std::vector<LayerProfile> getProfile();
+
+    /***
+     * Resets the profiles of all layers.
+     */
+    void resetProfile();
+
+    /***
+     * Formats the profiles of the layers as a table, see Profiler::report.
+     *
+     * @return Table with one row per layer and one with the totals
+     */
+    std::string profileReport();
+
+    /***
+     * Folds adjacent affine layers, each of which would otherwise consume a multiplicative level:
+     *  - a BatchNorm after a linear operator is folded into its weights and biases,
+     *  - two adjacent linear operators are composed into one matrix, unless that needs more rotations,
+     *  - a remaining BatchNorm before a linear operator is folded into its inputs,
+     *  - two adjacent BatchNorms are merged,
+     *  - the scale and shift of a ScaledSquare after a linear operator move into that operator.
+     * The given operators are left unchanged, folded layers are replaced by new operators. Linear operators that are
+     * not evaluated by their diagonal schedule are never folded.
+     *
+     * @param layers Operators in the order of the forward pass
+     * @return Folded layers
+     */
+    static std::vector<std::shared_ptr<Operator>> fold(const std::vector<std::shared_ptr<Operator>>& layers);
+
+    /***
+     * Inserts as few bootstraps as possible, so that no layer runs out of levels. A layer needs as many levels as
+     * getDepth returns. Among the placements with the fewest bootstraps the one with the most levels left at the end
+     * is chosen. Bootstraps that are already part of the layers are kept.
+     *
+     * @param inputLevels Levels left on the input ciphertexts, e.g. the multiplicative depth for fresh ciphertexts
+     * @param bootstrapLevels Levels left after a bootstrap, i.e. the multiplicative depth minus the depth of
+     * bootstrapping itself, see FHECKKSRNS::GetBootstrapDepth
+     * @return Plan of the application, which can be printed with BootstrapPlan::report
+     */
+    BootstrapPlan placeBootstraps(uint32_t inputLevels, uint32_t bootstrapLevels);
+
 private:
     std::vector<std::shared_ptr<Operator>> layers;
 
+    /***
+     * Graph that is evaluated instead of the layers, if set.
+     */
+    std::shared_ptr<Graph> graph;
+
+    /***
+     * Pool of forwardBatch, which is kept as long as the number of workers does not change. Guarded by poolMutex, as
+     * concurrent calls of forwardBatch may replace it.
+     */
+    std::shared_ptr<ThreadPool> pool;
+    std::mutex poolMutex;
+
 };
 
 
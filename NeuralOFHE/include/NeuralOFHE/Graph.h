@@ -0,0 +1,117 @@
+#ifndef NEURALOFHE_GRAPH_H
+#define NEURALOFHE_GRAPH_H
+
+#include <vector>
+#include <memory>
+#include <atomic>
+
+#include "Operators/InherOperators.h"
+
+
+/***
+ * Directed acyclic graph of operators, e.g. a model with residual connections.
+ *
+ * Nodes are identified by the index returned when adding them and can only consume nodes that were added before, so
+ * the order of insertion is topological. forward evaluates the graph in wavefronts: all nodes whose inputs are
+ * available run in parallel. The OpenMP threads are split evenly between the nodes of a wavefront, and every node
+ * runs the parallel loops of its operator with its share in a nested parallel region. Adding a node raises the
+ * maximum number of active OpenMP levels to two for that; a caller that evaluates the graph within a parallel region
+ * of its own has to raise it further. The ciphertext of a node is released as soon as its last consumer has finished,
+ * so only the intermediates that are still needed are kept alive.
+ */
+class Graph {
+public:
+    /***
+     * Adds an input of the graph.
+     *
+     * @return Index of the input node
+     */
+    size_t addInput();
+
+    /***
+     * Adds an operator that consumes the output of a node.
+     *
+     * @param op Operator of the node
+     * @param input Index of the consumed node
+     * @return Index of the new node
+     */
+    size_t addNode(std::shared_ptr<Operator> op, size_t input);
+
+    /***
+     * Adds an operator with several inputs, e.g. nn::Add or nn::Concat.
+     *
+     * @param op Operator of the node
+     * @param inputs Indices of the consumed nodes in the order the operator expects them
+     * @return Index of the new node
+     */
+    size_t addNode(std::shared_ptr<MultiInputOperator> op, std::vector<size_t> inputs);
+
+    /***
+     * Marks a node as an output of the graph. Outputs are returned in the order they were marked in.
+     *
+     * @param node Index of the node
+     */
+    void addOutput(size_t node);
+
+    /***
+     * Evaluates the graph.
+     *
+     * @param inputs Ciphertexts of the inputs in the order they were added in
+     * @return Ciphertexts of the outputs
+     */
+    std::vector<Ciphertext<DCRTPoly>> forward(const std::vector<Ciphertext<DCRTPoly>>& inputs);
+
+    /***
+     * Overload of forward for graphs with a single input and output.
+     */
+    Ciphertext<DCRTPoly> forward(Ciphertext<DCRTPoly> x);
+
+    /***
+     * Getter for the operators of all nodes in topological order.
+     *
+     * @return Operators of the graph
+     */
+    std::vector<std::shared_ptr<Operator>> getOperators();
+
+    /***
+     * Collects the rotation indices that a forward pass through all nodes requests.
+     *
+     * @return Rotation indices in ascending order
+     */
+    std::vector<int> getRotationIndices();
+
+    /***
+     * Getter for the largest number of ciphertexts that were alive at the same time during the last forward pass,
+     * including the inputs.
+     *
+     * @return Number of ciphertexts
+     */
+    size_t getPeakLiveCiphertexts();
+
+private:
+    struct Node {
+        /***
+         * Operator of the node, nullptr for inputs.
+         */
+        std::shared_ptr<Operator> op;
+        std::shared_ptr<MultiInputOperator> multiInput;
+
+        std::vector<size_t> inputs;
+
+        /***
+         * Length of the longest path from an input, nodes of the same wavefront run in parallel.
+         */
+        size_t wavefront;
+    };
+
+    size_t addNode(Node node);
+
+    std::vector<Node> nodes;
+    std::vector<size_t> inputNodes;
+    std::vector<size_t> outputNodes;
+
+    std::atomic<size_t> peakLive{0};
+};
+
+
+#endif //NEURALOFHE_GRAPH_H
@@ -14,6 +14,25 @@
 void SetContext(CryptoContext<DCRTPoly> context);
 
 
+/***
+ * Function that sets the memory budget of the plaintext caches of all operators created after the call. The budget of
+ * an existing operator can be changed with Operator::setCacheBudget.
+ *
+ * @param bytes Budget of each operators cache in bytes. A budget of 0 disables caching
+ */
+void SetPlaintextCacheBudget(size_t bytes);
+
+
+/***
+ * Function that switches the linear operators between single and double hoisted matrix multiplication. With double
+ * hoisting the plaintext products and giant step rotations are accumulated in the extended key switching basis, which
+ * saves most of the mod-downs of large layers. Requires a context with hybrid key switching.
+ *
+ * @param enabled Whether double hoisting should be used
+ */
+void SetDoubleHoisting(bool enabled);
+
+
 /***
  * Function that generates a vector of ints which is filled with the indices needed for matrix multiplication according
  * to the contexts batchSize
@@ -24,17 +43,28 @@ void SetContext(CryptoContext<DCRTPoly> context);
 std::vector<int> GetRotations (uint32_t batchSize);
 
 
+/***
+ * Function that returns exactly the rotation indices the forward passes of the given operators request. Generating
+ * only these keys is usually much cheaper than generating those of GetRotations(batchSize). Bootstrapping keys are not
+ * included, they are generated by EvalBootstrapKeyGen.
+ *
+ * @param layers Operators of the model in any order
+ * @return Rotation indices in ascending order
+ */
+std::vector<int> GetRotations (const std::vector<std::shared_ptr<Operator>>& layers);
+
+
 /***
  * Function that creates and returns shared pointer pointing to an Operator inherited object
  *
  * @tparam Operation Class of the Operation
  * @tparam Args
- * @param args Arguments of the classes constructor
+ * @param args Arguments of the classes constructor, which are forwarded without copies
  * @return Pointer to the Operation
  */
 template <typename Operation, typename... Args>
-extern std::shared_ptr<Operator> AddOperation (Args... args) {
-    std::shared_ptr<Operator> ptr(std::make_shared<Operation>(args...));
+extern std::shared_ptr<Operator> AddOperation (Args&&... args) {
+    std::shared_ptr<Operator> ptr(std::make_shared<Operation>(std::forward<Args>(args)...));
 
     return ptr;
 }
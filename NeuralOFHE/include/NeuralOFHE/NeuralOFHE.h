@@ -2,6 +2,11 @@
 #define NEURALOFHE_NEURALOFHE_H
 
 #include "Application.h"
+#include "Graph.h"
+#include "Npy.h"
+#include "Pipeline.h"
+#include "Profiler.h"
+#include "Tracer.h"
 #include "Helperfunctions/HelperFunctions.h"
 #include "Operators/InherOperators.h"
 
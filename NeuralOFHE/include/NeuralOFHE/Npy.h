@@ -0,0 +1,62 @@
+#ifndef NEURALOFHE_NPY_H
+#define NEURALOFHE_NPY_H
+
+#include <string>
+#include <vector>
+
+#include "Tensor.h"
+
+
+/***
+ * Header of a .npy file, see https://numpy.org/doc/stable/reference/generated/numpy.lib.format.html.
+ */
+struct NpyHeader {
+    /***
+     * Data type of the entries, '<f4' or '<f8'.
+     */
+    std::string descr;
+
+    bool fortranOrder = false;
+
+    std::vector<size_t> shape;
+
+    /***
+     * Offset of the first entry from the start of the file.
+     */
+    size_t dataOffset = 0;
+
+    size_t itemSize() const;
+
+    /***
+     * Number of entries, i.e. the product of the shape.
+     */
+    size_t size() const;
+};
+
+
+/***
+ * Reads and validates the header of a .npy file: the magic string, the format version, the keys of the header
+ * dictionary and the data type, which has to be little endian float or double. Exits if the file is no valid .npy
+ * file of such entries.
+ *
+ * @param path Path of the file
+ * @return Parsed header
+ */
+NpyHeader ReadNpyHeader(const std::string& path);
+
+
+/***
+ * Loads a .npy file of little endian floats or doubles as a read-only tensor by mapping the file into memory.
+ *
+ * Doubles in C order are not copied at all: the tensor is a view on the mapped file, which stays mapped as long as
+ * any tensor refers to it, so loading costs no more than paging in the entries that are actually read. Floats are
+ * widened and arrays in fortran order are transposed into row-major order, both in a single pass over the mapped file.
+ * The header is validated as in ReadNpyHeader and the size of the file has to match the shape.
+ *
+ * @param path Path of the file
+ * @return Tensor with the shape of the array, in row-major order
+ */
+Tensor LoadNpy(const std::string& path);
+
+
+#endif //NEURALOFHE_NPY_H
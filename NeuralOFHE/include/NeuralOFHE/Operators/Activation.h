@@ -2,6 +2,7 @@
 #define NEURALOFHE_ACTIVATION_H
 
 #include "Operator.h"
+#include <functional>
 
 
 /***
@@ -28,6 +29,28 @@ public:
      */
     Ciphertext<DCRTPoly> forward(Ciphertext<DCRTPoly> x) override;
 
+    /***
+     * Getter for the coefficients of the Chebyshev series that approximates the function on [Min, Max]. They are
+     * computed on the first call and shared by all activations with the same function identifier, interval and degree.
+     *
+     * @return polyDeg + 1 Chebyshev coefficients
+     */
+    std::vector<double> getCoefficients();
+
+    /***
+     * Sets the coefficients of the Chebyshev series, e.g. after loading them together with a model. They replace the
+     * coefficients of this activation only.
+     *
+     * @param coefficients Chebyshev coefficients for the interval [Min, Max]
+     */
+    void setCoefficients(std::vector<double> coefficients);
+
+    /***
+     * Depth of OpenFHE's evaluation of a Chebyshev series of degree polyDeg, which uses the Paterson-Stockmeyer method
+     * for degrees above 5.
+     */
+    uint32_t getDepth() override;
+
 protected:
     /***
      * Minimum, maximum and degree of the polynomial needed for the Chebyshev approximation.
@@ -42,6 +65,27 @@ protected:
      * @return Plain activation function
      */
     virtual const std::function<double (double)> &getFunc() = 0;
+
+    /***
+     * Virtual method that returns a process-wide unique identifier of the function returned by getFunc, under which
+     * its Chebyshev coefficients are cached. Activations with an empty identifier, e.g. those defined in Python,
+     * compute their coefficients once per object instead.
+     *
+     * @return Identifier of the function
+     */
+    virtual std::string getFuncId();
+
+private:
+    /***
+     * Returns the coefficients and computes them if necessary. The shared pointer keeps them alive during forward,
+     * even if setCoefficients replaces them in the meantime.
+     */
+    std::shared_ptr<const std::vector<double>> sharedCoefficients();
+
+    /***
+     * Chebyshev coefficients of the function, set by sharedCoefficients or setCoefficients.
+     */
+    std::shared_ptr<const std::vector<double>> coefficients;
 };
 
 #endif //NEURALOFHE_ACTIVATION_H
@@ -0,0 +1,24 @@
+#ifndef NEURALOFHE_ADD_H
+#define NEURALOFHE_ADD_H
+
+#include "MultiInputOperator.h"
+
+namespace nn {
+    /***
+     * Encrypted sum of all inputs, e.g. of a residual connection. Inputs on different levels are brought to the lower
+     * level by EvalAdd, no level is consumed.
+     */
+    class Add : public MultiInputOperator {
+    public:
+        Add();
+
+        using MultiInputOperator::forward;
+
+        Ciphertext<DCRTPoly> forward(const std::vector<Ciphertext<DCRTPoly>>& inputs) override;
+
+    private:
+        static uint32_t numAdd;
+    };
+}
+
+#endif //NEURALOFHE_ADD_H
@@ -2,8 +2,27 @@
 #define NEURALOFHE_AVERAGEPOOL_H
 
 #include "GeneralLinearOperator.h"
+#include "SlotLayout.h"
 
 namespace nn {
+    /***
+     * Shape parameters of a two dimensional average pooling. Height and width belong to the input image.
+     */
+    struct Pool2DParams {
+        uint32_t channels;
+        uint32_t height;
+        uint32_t width;
+        uint32_t kernelHeight;
+        uint32_t kernelWidth;
+        uint32_t stride = 1;
+        uint32_t padding = 0;
+
+        /***
+         * Whether the padded zeros count towards the window size of windows at the border.
+         */
+        bool countIncludePad = false;
+    };
+
     class AveragePool : public GeneralLinearOperator {
     public:
         /***
@@ -12,10 +31,62 @@ namespace nn {
          *
          * @param matrix Matrix that contains the transformed average pooling operation.
          */
-        AveragePool(matVec matrix);
+        AveragePool(Tensor matrix);
+
+        /***
+         * Average pooling built from its window, for an input that is packed densely as flattened CHW tensor.
+         *
+         * Without padding and with a stride of 1 every window is summed up by rotating the input along the rows and
+         * then along the columns, which needs O(log(kernel size)) rotations, followed by a multiplication with the
+         * inverse window size. Otherwise pooling is evaluated as a depthwise convolution: with padding the windows at
+         * the border have a different size, and like for Conv2D a stride > 1 leads to a multiplexed output, into which
+         * the channels have to be moved.
+         *
+         * @param params Shape of the pooling
+         */
+        AveragePool(Pool2DParams params);
+
+        /***
+         * Overload of the window constructor for an input with the given layout.
+         *
+         * @param params Shape of the pooling
+         * @param inputLayout Layout of the input, which has to match the input shape of params
+         */
+        AveragePool(Pool2DParams params, SlotLayout inputLayout);
+
+        Ciphertext<DCRTPoly> forward(Ciphertext<DCRTPoly> x) override;
+
+        void warmUp(uint32_t level) override;
+
+        std::vector<int> getRotationIndices() override;
+
+        uint32_t getOutputSize() override;
+
+        /***
+         * Getter for the layout of the output. Only meaningful for pooling built from its window.
+         *
+         * @return Output layout
+         */
+        SlotLayout getOutputLayout();
+
+        /***
+         * Slots of the output in the order of the flattened CHW output tensor.
+         *
+         * @return Slot of every output entry
+         */
+        std::vector<uint32_t> getOutputSlots();
 
     private:
         static uint32_t numAvgPool;
+
+        Pool2DParams params;
+        SlotLayout inputLayout;
+        SlotLayout outputLayout;
+
+        /***
+         * Whether forward uses rotate-and-sum instead of the diagonal schedule.
+         */
+        bool rotateAndSum = false;
     };
 }
 
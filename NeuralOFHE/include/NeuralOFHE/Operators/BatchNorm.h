@@ -10,6 +10,17 @@ namespace nn {
 
         Ciphertext<DCRTPoly> forward(Ciphertext<DCRTPoly> x) override;
 
+        void warmUp(uint32_t level) override;
+
+        uint32_t getDepth() override;
+
+        /***
+         * Getters for the factor and the summand of every slot, which are used to fold the normalization into an
+         * adjacent linear operator.
+         */
+        const std::vector<double>& getWeights();
+        const std::vector<double>& getBiases();
+
     private:
         /***
          * Operation counter.
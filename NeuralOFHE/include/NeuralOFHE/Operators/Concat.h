@@ -0,0 +1,52 @@
+#ifndef NEURALOFHE_CONCAT_H
+#define NEURALOFHE_CONCAT_H
+
+#include "MultiInputOperator.h"
+
+namespace nn {
+    /***
+     * Concatenation of inputs whose meaningful slots start at slot 0. Input i is rotated to the right by the sizes of
+     * all inputs before it and the results are summed up.
+     */
+    class Concat : public MultiInputOperator {
+    public:
+        /***
+         * Constructor of a concatenation.
+         *
+         * @param sizes Number of meaningful slots of every input
+         * @param mask Whether the slots of every input beyond its size are zeroed by a plaintext multiplication, which
+         * consumes a level. Can be turned off if the inputs are known to be zero there
+         */
+        Concat(std::vector<uint32_t> sizes, bool mask = true);
+
+        using MultiInputOperator::forward;
+
+        Ciphertext<DCRTPoly> forward(const std::vector<Ciphertext<DCRTPoly>>& inputs) override;
+
+        size_t getNumInputs() override;
+
+        void warmUp(uint32_t level) override;
+
+        std::vector<int> getRotationIndices() override;
+
+        uint32_t getDepth() override;
+
+        uint32_t getOutputSize() override;
+
+    private:
+        static uint32_t numConcat;
+
+        /***
+         * First slot of every input in the output.
+         */
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> sizes;
+
+        /***
+         * Masks of the slots of every input after rotating it, empty if masking is turned off.
+         */
+        std::vector<std::vector<double>> masks;
+    };
+}
+
+#endif //NEURALOFHE_CONCAT_H
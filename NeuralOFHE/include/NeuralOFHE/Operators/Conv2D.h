@@ -2,6 +2,7 @@
 #define NEURALOFHE_CONV2D_H
 
 #include "GeneralLinearOperator.h"
+#include "SlotLayout.h"
 #include <vector>
 
 namespace nn {
@@ -13,10 +14,53 @@ namespace nn {
          * @param weights Transformed matrix containing the Convolutional operation.
          * @param bias Transformed biases.
          */
-        Conv2D(std::vector<std::vector<double>> weights, std::vector<double> bias);
+        Conv2D(Tensor weights, std::vector<double> bias);
+
+        /***
+         * Convolution built from its kernel, for an input that is packed densely as flattened CHW tensor.
+         *
+         * Every combination of kernel offset and input and output channel shifts the input by a fixed number of slots,
+         * so the convolution only has as many diagonals as there are distinct shifts. They are evaluated as masked
+         * rotations by the baby-step giant-step method, the masks zero out the padding and hold the kernel weights. The
+         * number of rotations therefore grows with the kernel size and the number of channels, not with the image size.
+         * With a stride > 1 the output is multiplexed, see SlotLayout and getOutputLayout.
+         *
+         * @param kernel Kernel weights of shape outChannels x inChannels x kernelHeight x kernelWidth, flattened
+         * @param bias Bias of every output channel. May be empty
+         * @param params Shape of the convolution
+         */
+        Conv2D(std::vector<double> kernel, std::vector<double> bias, Conv2DParams params);
+
+        /***
+         * Overload of the kernel constructor for an input with the given layout, e.g. the output of a previous
+         * convolution.
+         *
+         * @param kernel Kernel weights of shape outChannels x inChannels x kernelHeight x kernelWidth, flattened
+         * @param bias Bias of every output channel. May be empty
+         * @param params Shape of the convolution
+         * @param inputLayout Layout of the input, which has to match the input shape of params
+         */
+        Conv2D(std::vector<double> kernel, std::vector<double> bias, Conv2DParams params, SlotLayout inputLayout);
+
+        /***
+         * Getter for the layout of the output. Only meaningful for convolutions built from a kernel.
+         *
+         * @return Output layout
+         */
+        SlotLayout getOutputLayout();
+
+        /***
+         * Slots of the output in the order of the flattened CHW output tensor. A following dense layer can be
+         * applied to the multiplexed output by moving row i of its weight matrix to row getOutputSlots()[i].
+         *
+         * @return Slot of every output entry
+         */
+        std::vector<uint32_t> getOutputSlots();
 
     private:
         static uint32_t numConv;
+
+        SlotLayout outputLayout;
     };
 }
 
@@ -9,7 +9,7 @@
 namespace nn {
     class Gemm : public GeneralLinearOperator {
     public:
-        Gemm(matVec matrix, std::vector<double> bias);
+        Gemm(Tensor matrix, std::vector<double> bias);
 
     private:
         static uint32_t numGemm;
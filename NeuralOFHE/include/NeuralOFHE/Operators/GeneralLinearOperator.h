@@ -7,18 +7,99 @@
 
 #include "Operator.h"
 
+/***
+ * Plaintext diagonals of the matrix in baby-step giant-step order. Defined in src/LinTools.h.
+ */
+struct DiagonalSchedule;
+
 class GeneralLinearOperator : public Operator {
 public:
-    GeneralLinearOperator (matVec weights, unsigned int& objCounter, std::string name);
+    /***
+     * Constructors of a linear operator from its weight matrix of shape input size x output size. The weights are
+     * moved into the operator, so passing a temporary or a std::move'd tensor avoids any copy of the matrix.
+     */
+    GeneralLinearOperator (Tensor weights, unsigned int& objCounter, std::string name);
 
-    GeneralLinearOperator (matVec weights, std::vector<double> biases, unsigned int& objCounter, std::string name);
+    GeneralLinearOperator (Tensor weights, std::vector<double> biases, unsigned int& objCounter, std::string name);
 
     Ciphertext<DCRTPoly> forward (Ciphertext<DCRTPoly> x) override;
 
-private:
-    matVec weights;
+    void warmUp(uint32_t level) override;
+
+    std::vector<int> getRotationIndices() override;
+
+    /***
+     * The diagonals are multiplied with one plaintext each, which consumes a single level.
+     */
+    uint32_t getDepth() override;
+
+    uint32_t getOutputSize() override;
+
+    /***
+     * Whether forward evaluates the diagonal schedule of the operator, so that the fold methods below can change its
+     * linear map. Operators that are evaluated differently, e.g. AveragePool by rotate-and-sum, cannot be folded.
+     */
+    bool isFoldable();
+
+    /***
+     * Returns a new operator that computes scale * forward(x) + shift with a single plaintext multiplication, e.g.
+     * for a following BatchNorm. The outputs of the weights and the biases are scaled, the operator itself is left
+     * unchanged.
+     *
+     * @param scale Factor of every output slot, missing entries are zero
+     * @param shift Summand of every output slot, missing entries are zero
+     * @param foldedName Name of the folded operator, which is appended to the name of the result
+     * @return Folded operator
+     */
+    std::shared_ptr<GeneralLinearOperator> foldOutputAffine(const std::vector<double>& scale,
+                                                            const std::vector<double>& shift,
+                                                            const std::string& foldedName);
+
+    /***
+     * Returns a new operator that computes forward(scale * x + shift) with a single plaintext multiplication, e.g. for
+     * a preceding BatchNorm. The inputs of the weights are scaled and the shift is moved into the biases.
+     *
+     * @param scale Factor of every input slot, missing entries are zero
+     * @param shift Summand of every input slot, missing entries are zero
+     * @param foldedName Name of the folded operator, which is prepended to the name of the result
+     * @return Folded operator
+     */
+    std::shared_ptr<GeneralLinearOperator> foldInputAffine(const std::vector<double>& scale,
+                                                           const std::vector<double>& shift,
+                                                           const std::string& foldedName);
+
+    /***
+     * Returns a new operator that computes next.forward(forward(x)) with a single matrix. Dense weight matrices are
+     * multiplied, otherwise the diagonals are composed directly. Composition is skipped if the result needs more
+     * rotations and multiplications than both operators together, which is the case for e.g. a convolution built
+     * from its kernel followed by a dense layer.
+     *
+     * @param next Operator that is applied after this one
+     * @return Composed operator or nullptr if both should stay separate
+     */
+    std::shared_ptr<GeneralLinearOperator> compose(GeneralLinearOperator& next);
+
+protected:
+    /***
+     * Constructor for inherited operators that build their diagonal schedule and biases themselves instead of from a
+     * dense weight matrix.
+     */
+    GeneralLinearOperator (unsigned int& objCounter, std::string name);
+
+    Tensor weights;
     std::vector<double> biases;
 
+    /***
+     * Diagonals of the weight matrix, built once at construction so that forward only does homomorphic work.
+     */
+    std::shared_ptr<DiagonalSchedule> schedule;
+
+private:
+    /***
+     * Counter of the operators created by folding.
+     */
+    static uint32_t numFolded;
+
 };
 
 
@@ -13,5 +13,9 @@
 #include "Sigmoid.h"
 #include "BootStrapping.h"
 #include "PadOperator.h"
+#include "Polynomial.h"
+#include "MultiInputOperator.h"
+#include "Add.h"
+#include "Concat.h"
 
 #endif //NEURALOFHE_INHEROPERATORS_H
@@ -0,0 +1,45 @@
+#ifndef NEURALOFHE_MULTIINPUTOPERATOR_H
+#define NEURALOFHE_MULTIINPUTOPERATOR_H
+
+#include "Operator.h"
+
+/***
+ * Base class for operators with several inputs, e.g. the encrypted sum of a residual connection. They are used as
+ * nodes of a Graph.
+ */
+class MultiInputOperator : public Operator {
+public:
+    MultiInputOperator(uint32_t& objCounter, std::string name);
+
+    /***
+     * Virtual function that represents applying the operation to the inputs.
+     *
+     * @param inputs Inputs in the order they were connected in
+     * @return Output
+     */
+    virtual Ciphertext<DCRTPoly> forward(const std::vector<Ciphertext<DCRTPoly>>& inputs) = 0;
+
+    /***
+     * Applies the operator to a single input.
+     */
+    Ciphertext<DCRTPoly> forward(Ciphertext<DCRTPoly> x) override;
+
+    /***
+     * Applies forward to the inputs and records it in the profile of the operator, see Operator::evaluate.
+     *
+     * @param inputs Inputs in the order they were connected in
+     * @return Output
+     */
+    Ciphertext<DCRTPoly> evaluate(const std::vector<Ciphertext<DCRTPoly>>& inputs);
+
+    using Operator::evaluate;
+
+    /***
+     * Getter for the number of inputs the operator expects.
+     *
+     * @return Number of inputs or 0 if any number is allowed
+     */
+    virtual size_t getNumInputs();
+};
+
+#endif //NEURALOFHE_MULTIINPUTOPERATOR_H
@@ -3,12 +3,23 @@
 
 #include <string>
 #include <vector>
+#include <functional>
 #include "openfhe.h"
-
-using matVec = std::vector<std::vector<double>>;
+#include "../Tensor.h"
+#include "../Profiler.h"
 
 using namespace lbcrypto;
 
+/***
+ * Cache of encoded plaintexts. Defined in src/PlaintextCache.h.
+ */
+class PlaintextCache;
+
+/***
+ * Accumulated profile of an operator together with its mutex. Defined in src/Operator.cpp.
+ */
+struct ProfileState;
+
 /***
  * Base class for all ML Operators.
  */
@@ -36,6 +47,28 @@ public:
      */
     virtual Ciphertext<DCRTPoly> forward(Ciphertext<DCRTPoly> x) = 0;
 
+    /***
+     * Applies forward and, if profiling is enabled, adds its wall time, HE operations, levels and ciphertext sizes to
+     * the profile of the operator. If tracing is enabled, it records a span and the latency, see Tracer. Code that runs
+     * layers, e.g. Application, should call this instead of forward.
+     *
+     * @param x Input
+     * @return Output
+     */
+    Ciphertext<DCRTPoly> evaluate(Ciphertext<DCRTPoly> x);
+
+    /***
+     * Getter for the profile accumulated by evaluate since the last reset.
+     *
+     * @return Profile of the operator
+     */
+    LayerProfile getProfile();
+
+    /***
+     * Resets the profile of the operator.
+     */
+    void resetProfile();
+
     /***
      * Static method that sets the context object for all ML Operations, which then essentially initializes a
      * Crypto Environment.
@@ -44,6 +77,13 @@ public:
      */
     static void initialize(CryptoContext<DCRTPoly> cc);
 
+    /***
+     * Getter for the context object set by initialize.
+     *
+     * @return CryptoContext of the application
+     */
+    static CryptoContext<DCRTPoly> getContext();
+
     /***
      * Static method that sets verbosity of application.
      *
@@ -70,6 +110,45 @@ public:
      */
     std::string getName();
 
+    /***
+     * Sets the memory budget of the operators cache of encoded plaintexts. A budget of 0 disables caching.
+     *
+     * @param bytes Budget in bytes
+     */
+    void setCacheBudget(size_t bytes);
+
+    /***
+     * Encodes all plaintexts of the operator for the given level in parallel, so that following calls of forward with
+     * ciphertexts on that level do not need to encode anything. Does nothing for operators without plaintexts.
+     *
+     * @param level Level of the ciphertexts that will be passed to forward. For a product that was not rescaled yet
+     * this is the level after rescaling, see PlaintextCache::multiplicationLevel
+     */
+    virtual void warmUp(uint32_t level);
+
+    /***
+     * Returns the rotation indices forward will request, so that only those rotation keys have to be generated.
+     * Indices are normalized to [0, batchSize). Empty for operators that do not rotate.
+     *
+     * @return Rotation indices in ascending order
+     */
+    virtual std::vector<int> getRotationIndices();
+
+    /***
+     * Returns the number of multiplicative levels a forward pass consumes, i.e. the number of rescalings between its
+     * input and its output. 0 for operators that do not multiply.
+     *
+     * @return Multiplicative depth
+     */
+    virtual uint32_t getDepth();
+
+    /***
+     * Returns the number of meaningful slots of the output.
+     *
+     * @return Output size or 0 if the output has as many meaningful slots as the input
+     */
+    virtual uint32_t getOutputSize();
+
 protected:
     /***
      * Static variable pointing to the context object of the application.
@@ -85,6 +164,25 @@ protected:
      * Name variable which can be useful for debugging applications.
      */
     std::string name;
+
+    /***
+     * Cache of the plaintexts encoded by this operator, keyed by an index of the operators choosing and the level and
+     * scaling factor of the input ciphertext.
+     */
+    std::shared_ptr<PlaintextCache> cache;
+
+    /***
+     * Runs a forward pass on the given inputs and records it in the profile of the operator.
+     *
+     * @param inputs Inputs of the forward pass
+     * @param run Function running the forward pass
+     * @return Output
+     */
+    Ciphertext<DCRTPoly> profiled(const std::vector<Ciphertext<DCRTPoly>>& inputs,
+                                  const std::function<Ciphertext<DCRTPoly>()>& run);
+
+private:
+    std::shared_ptr<ProfileState> profile;
 };
 
 
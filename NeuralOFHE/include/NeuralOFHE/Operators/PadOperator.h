@@ -2,15 +2,79 @@
 #define NEURALPY_PADOPERATOR_H
 
 #include "GeneralLinearOperator.h"
+#include "SlotLayout.h"
 
 namespace nn {
+    /***
+     * Shape parameters of a zero padding. Height and width belong to the input image.
+     */
+    struct PadParams {
+        uint32_t channels;
+        uint32_t height;
+        uint32_t width;
+        uint32_t top = 0;
+        uint32_t bottom = 0;
+        uint32_t left = 0;
+        uint32_t right = 0;
+    };
+
     class PadOperator : public GeneralLinearOperator {
     public:
-        PadOperator(matVec matrix, std::vector<double> bias);
+        PadOperator(Tensor matrix, std::vector<double> bias);
+
+        /***
+         * Zero padding built from its parameters, for an input that is packed densely as flattened CHW tensor.
+         *
+         * If the grid of the input layout has room for the padded image, padding is a single rotation that moves the
+         * image to its padded position, followed by a mask that zeroes the padding. Otherwise the image is moved into
+         * a larger dense layout by the diagonal schedule. A padding that is directly followed by a Conv2D should rather
+         * be set in its Conv2DParams, where it is free.
+         *
+         * @param params Shape of the padding
+         */
+        PadOperator(PadParams params);
+
+        /***
+         * Overload of the parameter constructor for an input with the given layout.
+         *
+         * @param params Shape of the padding
+         * @param inputLayout Layout of the input, which has to match the input shape of params
+         */
+        PadOperator(PadParams params, SlotLayout inputLayout);
+
+        Ciphertext<DCRTPoly> forward(Ciphertext<DCRTPoly> x) override;
+
+        void warmUp(uint32_t level) override;
+
+        std::vector<int> getRotationIndices() override;
+
+        uint32_t getOutputSize() override;
+
+        /***
+         * Getter for the layout of the output. Only meaningful for paddings built from their parameters.
+         *
+         * @return Output layout
+         */
+        SlotLayout getOutputLayout();
+
+        /***
+         * Slots of the output in the order of the flattened CHW output tensor.
+         *
+         * @return Slot of every output entry
+         */
+        std::vector<uint32_t> getOutputSlots();
 
     private:
         static uint32_t numPadOperator;
 
+        SlotLayout outputLayout;
+
+        /***
+         * Rotation of the masked fast path, which moves the image to its padded position, and the mask keeping only the
+         * image. The mask is empty if the diagonal schedule is used.
+         */
+        uint32_t rotation = 0;
+        std::vector<double> mask;
     };
 }
 
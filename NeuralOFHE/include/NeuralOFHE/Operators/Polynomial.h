@@ -0,0 +1,120 @@
+#ifndef NEURALOFHE_POLYNOMIAL_H
+#define NEURALOFHE_POLYNOMIAL_H
+
+#include "Activation.h"
+
+namespace nn {
+    /***
+     * Basis in which the coefficients of a polynomial activation are given.
+     *
+     * POWER: p(x) = c_0 + c_1 x + c_2 x^2 + ...
+     * CHEBYSHEV: p(x) = c_0 / 2 + c_1 T_1(t) + c_2 T_2(t) + ... with t = (2x - (max + min)) / (max - min), which is
+     * the convention of EvalChebyshevSeries and ActivationFunction::getCoefficients.
+     */
+    enum class PolynomialBasis {
+        POWER,
+        CHEBYSHEV
+    };
+
+    /***
+     * Activation given by the coefficients of a polynomial, e.g. a trained or minimax approximation of low degree.
+     *
+     * Every monomial c_k x^k is evaluated as a product tree over c_k x and the powers x^(2^i) of the binary digits of
+     * k - 1, in which the two shallowest factors are always multiplied first. The constant is thereby multiplied into x
+     * before any other multiplication, so a polynomial of degree d consumes ceil(log2(d + 1)) levels, the minimum for
+     * a degree d polynomial. Coefficients of +-1 need no multiplication at all, so x^2 only consumes one level. The
+     * generic Chebyshev evaluation of OpenFHE needs at least three levels.
+     */
+    class PolynomialActivation : public ActivationFunction {
+    public:
+        /***
+         * Constructor of a polynomial activation.
+         *
+         * @param coefficients Coefficients of the polynomial, starting with the constant term
+         * @param basis Basis of the coefficients, which are converted to the power basis
+         * @param min Lower bound of the interval of a Chebyshev basis
+         * @param max Upper bound of the interval of a Chebyshev basis
+         */
+        PolynomialActivation(std::vector<double> coefficients, PolynomialBasis basis = PolynomialBasis::POWER,
+                             double min = -1, double max = 1);
+
+        Ciphertext<DCRTPoly> forward(Ciphertext<DCRTPoly> x) override;
+
+        /***
+         * Depth of the product trees of forward, see the class description.
+         */
+        uint32_t getDepth() override;
+
+        /***
+         * Getter for the coefficients in the power basis.
+         *
+         * @return Coefficients starting with the constant term
+         */
+        const std::vector<double>& getPowerCoefficients();
+
+    protected:
+        /***
+         * Constructor for inherited activations, which use their own name and object counter.
+         */
+        PolynomialActivation(std::vector<double> coefficients, uint32_t& objCounter, std::string name);
+
+        /***
+         * Coefficients in the power basis without trailing zeros.
+         */
+        std::vector<double> power;
+
+    private:
+        static uint32_t numPolynomial;
+
+        /***
+         * Plain evaluation of the polynomial, e.g. for ActivationFunction::getCoefficients.
+         */
+        std::function<double (double)> polynomial;
+
+        const std::function<double (double)> &getFunc() override;
+    };
+
+    /***
+     * CryptoNets activation x^2, which consumes a single level.
+     */
+    class Square : public PolynomialActivation {
+    public:
+        Square();
+
+    private:
+        static uint32_t numSquare;
+    };
+
+    /***
+     * Activation a x^2 + b x + c. It consumes two levels on its own, but only one after Application::fold has moved
+     * the scale and the shift into the preceding linear operator, see normalized.
+     */
+    class ScaledSquare : public PolynomialActivation {
+    public:
+        ScaledSquare(double a, double b = 0, double c = 0);
+
+        double getA();
+        double getB();
+        double getC();
+
+        /***
+         * Whether the activation is of the form +-x^2 + c, which consumes a single level.
+         */
+        bool isNormalized();
+
+        /***
+         * Writes a x^2 + b x + c as sign(a) (s x + t)^2 + c'. A preceding linear operator that is scaled by s and
+         * shifted by t can be followed by the normalized activation sign(a) x^2 + c' instead.
+         *
+         * @param s Output scale of the preceding operator, sqrt(|a|)
+         * @param t Output shift of the preceding operator, s b / (2a)
+         * @return Normalized activation
+         */
+        std::shared_ptr<ScaledSquare> normalized(double& s, double& t);
+
+    private:
+        static uint32_t numScaledSquare;
+    };
+}
+
+#endif //NEURALOFHE_POLYNOMIAL_H
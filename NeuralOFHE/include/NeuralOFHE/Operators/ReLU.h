@@ -17,6 +17,8 @@ namespace nn {
         const static std::function<double (double)> relu;
 
         const std::function<double (double)> &getFunc() override;
+
+        std::string getFuncId() override;
     };
 }
 
@@ -17,6 +17,8 @@ namespace nn {
 
         const std::function<double (double)> &getFunc() override;
 
+        std::string getFuncId() override;
+
     };
 }
 
@@ -0,0 +1,64 @@
+#ifndef NEURALOFHE_SLOTLAYOUT_H
+#define NEURALOFHE_SLOTLAYOUT_H
+
+#include <cstdint>
+#include <vector>
+
+namespace nn {
+    /***
+     * Placement of a channels x height x width image in the slots of a ciphertext.
+     *
+     * Channels are stored in blocks of blockSize slots, every block holds a grid whose rows are rowPitch slots apart.
+     * With a gap g > 1 the image is multiplexed: an entry (y, x) occupies only every g-th row and column of the grid and
+     * the g * g channels that share a block fill the positions in between. A dense image has gap 1, a row pitch equal
+     * to its width and a block size of height * width. Strided convolutions increase the gap instead of compacting their
+     * output, so that consecutive layers keep a fixed number of rotations per kernel offset.
+     */
+    struct SlotLayout {
+        uint32_t channels;
+        uint32_t height;
+        uint32_t width;
+
+        uint32_t gap;
+        uint32_t rowPitch;
+        uint32_t blockSize;
+
+        /***
+         * Layout of an image that is packed channel by channel and row by row without any gaps, i.e. the flattened
+         * CHW tensor.
+         */
+        static SlotLayout dense(uint32_t channels, uint32_t height, uint32_t width);
+
+        /***
+         * Slot of the entry (c, y, x).
+         */
+        uint32_t slot(uint32_t c, uint32_t y, uint32_t x) const;
+
+        /***
+         * Number of slots from the first slot up to the last occupied one.
+         */
+        uint32_t size() const;
+
+        /***
+         * Slots of all entries in the order of the flattened CHW tensor.
+         */
+        std::vector<uint32_t> slots() const;
+    };
+
+    /***
+     * Shape parameters of a two dimensional convolution. Height and width belong to the input image, padding is
+     * applied with zeros on all four sides.
+     */
+    struct Conv2DParams {
+        uint32_t inChannels;
+        uint32_t outChannels;
+        uint32_t height;
+        uint32_t width;
+        uint32_t kernelHeight;
+        uint32_t kernelWidth;
+        uint32_t stride = 1;
+        uint32_t padding = 0;
+    };
+}
+
+#endif //NEURALOFHE_SLOTLAYOUT_H
@@ -0,0 +1,138 @@
+#ifndef NEURALOFHE_PIPELINE_H
+#define NEURALOFHE_PIPELINE_H
+
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <future>
+#include <string>
+
+#include "Application.h"
+
+
+/***
+ * Configuration of one stage of a Pipeline.
+ */
+struct PipelineStage {
+    /***
+     * Number of consecutive layers of the application the stage runs.
+     */
+    size_t numLayers = 1;
+
+    /***
+     * Number of OpenMP threads the layers of the stage use. If 0, the OpenMP threads are split evenly between all
+     * stages, with at least one thread per stage.
+     */
+    int threads = 0;
+
+    /***
+     * Cores the thread of the stage is pinned to, no pinning if empty. Only supported on Linux.
+     */
+    std::vector<int> cores;
+};
+
+
+/***
+ * Statistics of one stage of a Pipeline, see Pipeline::getStats.
+ */
+struct PipelineStageStats {
+    /***
+     * Names of the layers of the stage, separated by " -> ".
+     */
+    std::string name;
+
+    /***
+     * Number of requests waiting in the input queue of the stage.
+     */
+    size_t queueDepth;
+
+    /***
+     * Capacity of the input queue of the stage.
+     */
+    size_t queueCapacity;
+
+    /***
+     * Number of requests the stage has finished.
+     */
+    size_t processed;
+
+    /***
+     * Fraction of the time since the start of the pipeline the stage spent in forward passes of its layers.
+     */
+    double utilization;
+};
+
+
+/***
+ * Streaming mode of an Application for a continuous stream of requests.
+ *
+ * The layers are split into stages, each of which runs on its own thread with its own OpenMP threads. Stages are
+ * connected by bounded queues, so while request n is in the activation of one stage, request n+1 already runs the
+ * convolution of the stage before. A full queue blocks the stage before it, which limits the number of requests in
+ * flight. By default the cores are split evenly between the stages, so a single request passes the stages without
+ * waiting, but every layer only runs on the threads of its stage. Its latency is therefore higher than that of
+ * forward, which gives every layer all cores, unless the stages are configured with more threads.
+ *
+ * The stage statistics show which stage limits the throughput: its queue is full and its utilization close to one,
+ * so it should get more threads or fewer layers.
+ */
+class Pipeline {
+public:
+    /***
+     * Constructor that starts one stage per layer, which split the OpenMP threads evenly.
+     *
+     * @param application Application whose layers are run, must not be built from a Graph
+     * @param queueCapacity Capacity of the queue in front of every stage
+     */
+    explicit Pipeline(const std::shared_ptr<Application>& application, size_t queueCapacity = 2);
+
+    /***
+     * Constructor that starts the given stages.
+     *
+     * @param application Application whose layers are run, must not be built from a Graph
+     * @param stages Stages in order, whose numbers of layers sum up to the number of layers of the application
+     * @param queueCapacity Capacity of the queue in front of every stage
+     */
+    Pipeline(const std::shared_ptr<Application>& application, const std::vector<PipelineStage>& stages,
+             size_t queueCapacity = 2);
+
+    /***
+     * Destructor that finishes all submitted requests and joins the stages.
+     */
+    ~Pipeline();
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    /***
+     * Submits a request to the first stage. Blocks as long as the queue of the first stage is full.
+     *
+     * @param x Input ciphertext
+     * @return Future of the output ciphertext
+     */
+    std::future<Ciphertext<DCRTPoly>> submit(Ciphertext<DCRTPoly> x);
+
+    /***
+     * Finishes all submitted requests and stops the stages. Requests cannot be submitted afterwards.
+     */
+    void close();
+
+    /***
+     * Getter for the current statistics of the stages.
+     *
+     * @return Statistics of the stages in order
+     */
+    std::vector<PipelineStageStats> getStats() const;
+
+private:
+    struct Stage;
+
+    void run(size_t index);
+
+    std::shared_ptr<Application> application;
+    std::vector<std::unique_ptr<Stage>> stages;
+    std::atomic<bool> closed{false};
+};
+
+
+#endif //NEURALOFHE_PIPELINE_H
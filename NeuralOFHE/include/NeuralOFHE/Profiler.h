@@ -0,0 +1,135 @@
+#ifndef NEURALOFHE_PROFILER_H
+#define NEURALOFHE_PROFILER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "openfhe.h"
+
+using namespace lbcrypto;
+
+
+/***
+ * Profile of the forward passes of one operator, accumulated over all calls since the last reset.
+ *
+ * Counters are incremented by the operators themselves, from the thread that called forward. Operations that OpenFHE
+ * performs internally, e.g. within EvalChebyshevSeries or EvalBootstrap, are not broken down further.
+ */
+struct LayerProfile {
+    std::string name;
+
+    /***
+     * Number of forward passes.
+     */
+    uint64_t calls = 0;
+
+    /***
+     * Total wall time of the forward passes in seconds.
+     */
+    double seconds = 0;
+
+    /***
+     * Hoisted rotations, which share the decomposition of their input.
+     */
+    uint64_t fastRotations = 0;
+
+    /***
+     * Rotations with a key switch of their own.
+     */
+    uint64_t rotations = 0;
+
+    uint64_t plainMults = 0;
+    uint64_t cipherMults = 0;
+
+    /***
+     * Multiplications with a single number.
+     */
+    uint64_t scalarMults = 0;
+
+    /***
+     * Rescales, i.e. levels consumed between the input and the output.
+     */
+    uint64_t rescales = 0;
+
+    /***
+     * Plaintexts that had to be encoded because they were not cached.
+     */
+    uint64_t encodes = 0;
+
+    /***
+     * Key switches of rotations and relinearizations.
+     */
+    uint64_t keySwitches = 0;
+
+    uint64_t bootstraps = 0;
+
+    /***
+     * Levels and sizes in bytes of the input and output ciphertexts of the last forward pass.
+     */
+    uint32_t inputLevel = 0;
+    uint32_t outputLevel = 0;
+    size_t inputBytes = 0;
+    size_t outputBytes = 0;
+
+    /***
+     * Adds the counters and times of another profile. Levels and sizes are taken from the other profile.
+     *
+     * @param other Profile of later forward passes
+     */
+    void add(const LayerProfile& other);
+};
+
+
+/***
+ * Switch and entry points of the per-layer instrumentation, see Operator::evaluate.
+ *
+ * While profiling is disabled, which is the default, every instrumented call site only checks a flag.
+ */
+class Profiler {
+public:
+    /***
+     * Enables or disables profiling for all operators.
+     *
+     * @param state
+     */
+    static void setEnabled(bool state);
+
+    static bool isEnabled();
+
+    /***
+     * Adds to a counter of the profile of the operator that currently runs on this thread. Does nothing if profiling is
+     * disabled or no operator runs.
+     *
+     * @param counter Member of LayerProfile, e.g. &LayerProfile::rotations
+     * @param n Amount to add
+     */
+    static void count(uint64_t LayerProfile::*counter, uint64_t n = 1);
+
+    /***
+     * Makes profile the one count adds to on this thread.
+     *
+     * @param profile Profile of the operator that starts running or nullptr
+     * @return Profile that was current before, to be restored once the operator has finished
+     */
+    static LayerProfile* setCurrent(LayerProfile* profile);
+
+    /***
+     * Size of a ciphertext in memory, i.e. of all its towers.
+     *
+     * @param x Ciphertext
+     * @return Size in bytes
+     */
+    static size_t ciphertextBytes(const Ciphertext<DCRTPoly>& x);
+
+    /***
+     * Formats profiles as a table with one row per layer and a row with the totals.
+     *
+     * @param profiles Profiles of the layers
+     * @return Table
+     */
+    static std::string report(const std::vector<LayerProfile>& profiles);
+};
+
+
+#endif //NEURALOFHE_PROFILER_H
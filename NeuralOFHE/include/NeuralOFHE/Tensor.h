@@ -0,0 +1,110 @@
+#ifndef NEURALOFHE_TENSOR_H
+#define NEURALOFHE_TENSOR_H
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+using matVec = std::vector<std::vector<double>>;
+
+
+/***
+ * Read-only tensor of doubles stored contiguously in row-major order.
+ *
+ * The storage is held by a shared pointer, so copying a tensor only copies its shape and moving it copies nothing. The
+ * pointer may alias memory owned by someone else, e.g. a numpy array that the Python bindings keep alive for as long
+ * as any tensor refers to it. Two dimensional tensors are used for weight matrices, whose rows are the input and whose
+ * columns are the output dimension.
+ */
+class Tensor {
+public:
+    /***
+     * Empty tensor without any entries.
+     */
+    Tensor();
+
+    /***
+     * Tensor of the given shape that is filled with zeros.
+     *
+     * @param shape Size of every dimension
+     */
+    explicit Tensor(std::vector<size_t> shape);
+
+    /***
+     * Tensor that takes over the given values without copying them.
+     *
+     * @param shape Size of every dimension
+     * @param values Entries in row-major order, whose number has to match the shape
+     */
+    Tensor(std::vector<size_t> shape, std::vector<double>&& values);
+
+    /***
+     * Tensor on memory that is owned by someone else. The shared pointer has to keep that memory alive, e.g. by an
+     * aliasing constructor or a custom deleter.
+     *
+     * @param shape Size of every dimension
+     * @param data Pointer to the entries in row-major order
+     */
+    Tensor(std::vector<size_t> shape, std::shared_ptr<const double> data);
+
+    /***
+     * Conversion from a nested vector, which copies the rows into contiguous storage once. All rows need the same size.
+     *
+     * @param matrix Matrix of shape rows x columns
+     */
+    Tensor(const matVec& matrix);
+
+    const std::vector<size_t>& shape() const;
+
+    size_t ndim() const;
+
+    /***
+     * Total number of entries.
+     */
+    size_t size() const;
+
+    bool empty() const;
+
+    /***
+     * Size of the first dimension and the number of entries belonging to one index of it, i.e. the shape of the
+     * tensor viewed as a matrix.
+     */
+    size_t rows() const;
+    size_t cols() const;
+
+    const double* data() const {
+        return storage.get();
+    }
+
+    /***
+     * Pointer to the entries of row i of the tensor viewed as a matrix.
+     */
+    const double* row(size_t i) const {
+        return storage.get() + i * stride;
+    }
+
+    /***
+     * Entry (i, j) of the tensor viewed as a matrix.
+     */
+    double operator()(size_t i, size_t j) const {
+        return storage.get()[i * stride + j];
+    }
+
+    /***
+     * Returns a contiguous copy of the transposed matrix.
+     */
+    Tensor transposed() const;
+
+    /***
+     * Copies the tensor viewed as a matrix into a nested vector.
+     */
+    matVec toMatVec() const;
+
+private:
+    std::vector<size_t> dims;
+    size_t stride;
+    std::shared_ptr<const double> storage;
+};
+
+
+#endif //NEURALOFHE_TENSOR_H
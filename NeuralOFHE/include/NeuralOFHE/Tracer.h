@@ -0,0 +1,124 @@
+#ifndef NEURALOFHE_TRACER_H
+#define NEURALOFHE_TRACER_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+
+/***
+ * Distribution of the latencies of one layer type, in buckets of powers of two microseconds.
+ */
+struct LatencyHistogram {
+    /***
+     * buckets[i] counts the latencies in [2^i, 2^(i+1)) microseconds, the first bucket also those below one.
+     */
+    std::vector<uint64_t> buckets;
+
+    uint64_t count = 0;
+    double minSeconds = 0;
+    double maxSeconds = 0;
+    double sumSeconds = 0;
+
+    /***
+     * Adds a latency to the histogram.
+     *
+     * @param seconds Latency in seconds
+     */
+    void add(double seconds);
+
+    /***
+     * Estimates a percentile from the buckets, as the upper bound of the bucket that contains it.
+     *
+     * @param p Percentile in [0, 100]
+     * @return Latency in seconds
+     */
+    double percentile(double p) const;
+};
+
+
+/***
+ * Opt-in tracer that records spans of operators, BSGS steps, encodings and OpenFHE calls per thread and exports them
+ * as Chrome trace JSON, which can be opened in chrome://tracing or Perfetto. Besides, it keeps a latency histogram per
+ * layer type.
+ *
+ * Every thread writes its spans into a buffer of its own, so recording needs no lock. While tracing is disabled, which
+ * is the default, a span only checks a flag.
+ */
+class Tracer {
+public:
+    /***
+     * Span that is recorded from its construction to its destruction.
+     */
+    class Span {
+    public:
+        /***
+         * Starts a span if tracing is enabled.
+         *
+         * @param category Category of the span, e.g. "operator" or "bsgs"
+         * @param name Name of the span, which is only copied if tracing is enabled
+         * @param index Index shown as argument of the span, e.g. the giant step, none if negative
+         */
+        Span(const char* category, const std::string& name, int64_t index = -1);
+        Span(const char* category, const char* name, int64_t index = -1);
+        ~Span();
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        void begin(const char* category, const char* name, int64_t index);
+
+        bool active = false;
+        const char* category = nullptr;
+        std::string name;
+        int64_t index = -1;
+        double start = 0;
+    };
+
+    /***
+     * Clears all recorded spans and histograms and enables tracing.
+     */
+    static void start();
+
+    /***
+     * Disables tracing, the recorded spans are kept until the next start.
+     */
+    static void stop();
+
+    static bool isEnabled();
+
+    /***
+     * Writes the recorded spans as Chrome trace JSON. Must not be called while traced code runs.
+     *
+     * @param filePath Path of the JSON file
+     */
+    static void write(const std::string& filePath);
+
+    /***
+     * Adds the latency of a forward pass to the histogram of its layer type, i.e. the name of the layer without its
+     * counter, e.g. "Conv2D" for "Conv2D_0". Does nothing if tracing is disabled.
+     *
+     * @param layerName Name of the layer
+     * @param seconds Latency in seconds
+     */
+    static void recordLatency(const std::string& layerName, double seconds);
+
+    /***
+     * Getter for the latency histograms recorded since the last start.
+     *
+     * @return Histograms by layer type
+     */
+    static std::map<std::string, LatencyHistogram> getHistograms();
+
+    /***
+     * Formats the latency histograms as a table with count, mean, p50, p90, p99 and max per layer type.
+     *
+     * @return Table
+     */
+    static std::string histogramReport();
+};
+
+
+#endif //NEURALOFHE_TRACER_H
@@ -1,4 +1,21 @@
 #include "NeuralOFHE/Operators/Activation.h"
+#include "NeuralOFHE/Tracer.h"
+
+#include <map>
+#include <mutex>
+#include <tuple>
+
+
+/***
+ * Chebyshev coefficients of all activations, keyed by the identifier of the function, the interval and the degree.
+ */
+static std::map<std::tuple<std::string, double, double, uint32_t>, std::shared_ptr<const std::vector<double>>>
+        coefficientCache;
+
+/***
+ * Guards coefficientCache and the coefficients of every activation.
+ */
+static std::mutex coefficientMutex;
 
 
 ActivationFunction::ActivationFunction(double Min, double Max, uint32_t polyDeg, uint32_t& objCounter,
@@ -10,6 +27,76 @@ ActivationFunction::ActivationFunction(double Min, double Max, uint32_t polyDeg,
 
 
 Ciphertext<DCRTPoly> ActivationFunction::forward(Ciphertext<lbcrypto::DCRTPoly> x) {
-    std::function<double (double)> function = getFunc();
-    return context->EvalChebyshevFunction(function, x, Min, Max, polyDeg);
+    auto series = sharedCoefficients();
+
+    Tracer::Span span("openfhe", "EvalChebyshevSeries");
+    return context->EvalChebyshevSeries(x, *series, Min, Max);
+}
+
+
+std::vector<double> ActivationFunction::getCoefficients() {
+    return *sharedCoefficients();
+}
+
+
+std::shared_ptr<const std::vector<double>> ActivationFunction::sharedCoefficients() {
+    std::string id = getFuncId();
+    auto key = std::make_tuple(id, Min, Max, polyDeg);
+
+    {
+        std::lock_guard<std::mutex> lock(coefficientMutex);
+
+        if (coefficients)
+            return coefficients;
+
+        auto it = coefficientCache.find(key);
+        if (!id.empty() && it != coefficientCache.end()) {
+            coefficients = it->second;
+            return coefficients;
+        }
+    }
+
+    //  Computed without holding the lock, as the function of an activation defined in Python needs the GIL, which
+    //  another thread might hold while waiting for the lock. Threads that miss at the same time compute the same
+    //  coefficients, the first one to finish is kept
+    auto computed = std::make_shared<const std::vector<double>>(
+            EvalChebyshevCoefficients(getFunc(), Min, Max, polyDeg));
+
+    std::lock_guard<std::mutex> lock(coefficientMutex);
+
+    if (coefficients)
+        return coefficients;
+
+    if (!id.empty())
+        computed = coefficientCache.emplace(key, computed).first->second;
+
+    coefficients = computed;
+    return coefficients;
+}
+
+
+void ActivationFunction::setCoefficients(std::vector<double> coefficients) {
+    std::lock_guard<std::mutex> lock(coefficientMutex);
+    this->coefficients = std::make_shared<const std::vector<double>>(std::move(coefficients));
+}
+
+
+uint32_t ActivationFunction::getDepth() {
+    //  Largest degree that can be evaluated with a depth of 4, 5, ... according to the documentation of OpenFHE, see
+    //  FUNCTION_EVALUATION.md
+    static const uint32_t maxDegree[] = {5, 13, 27, 59, 119, 247, 495, 1007, 2031};
+
+    uint32_t depth = 4;
+    for (uint32_t degree : maxDegree) {
+        if (polyDeg <= degree)
+            return depth;
+        depth++;
+    }
+
+    return depth;
+}
+
+
+std::string ActivationFunction::getFuncId() {
+    return "";
 }
@@ -0,0 +1,22 @@
+#include "NeuralOFHE/Operators/Add.h"
+
+uint32_t nn::Add::numAdd = 0;
+
+
+nn::Add::Add() : MultiInputOperator(numAdd, "Add_" + std::to_string(numAdd)) {
+
+}
+
+
+Ciphertext<DCRTPoly> nn::Add::forward(const std::vector<Ciphertext<DCRTPoly>>& inputs) {
+    if (inputs.empty()) {
+        std::cerr << name << ": Nothing to add." << std::endl;
+        exit(1);
+    }
+
+    Ciphertext<DCRTPoly> result = inputs[0];
+    for (size_t i = 1; i < inputs.size(); i++)
+        result = context->EvalAdd(result, inputs[i]);
+
+    return result;
+}
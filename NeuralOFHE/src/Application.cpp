@@ -1,14 +1,337 @@
 #include "NeuralOFHE/Application.h"
+#include "NeuralOFHE/Helperfunctions/HelperFunctions.h"
+#include "ThreadPool.h"
 
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <future>
+#include <thread>
 
-Application::Application(const std::vector<std::shared_ptr<Operator>> &layers) {
-    this->layers = layers;
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+Application::Application(const std::vector<std::shared_ptr<Operator>> &layers, bool fold) {
+    this->layers = fold ? Application::fold(layers) : layers;
+}
+
+
+Application::Application(std::shared_ptr<Graph> graph) {
+    this->graph = graph;
+    this->layers = graph->getOperators();
 }
 
 
 Ciphertext<DCRTPoly> Application::forward(Ciphertext<DCRTPoly> x) {
+    if (graph)
+        return graph->forward(x);
+
     for (const auto& layer : layers)
-        x = layer->forward(x);
+        x = layer->evaluate(x);
 
     return x;
 }
+
+
+std::vector<Ciphertext<DCRTPoly>> Application::forwardBatch(const std::vector<Ciphertext<DCRTPoly>>& inputs,
+                                                            uint32_t threads) {
+    if (inputs.empty())
+        return {};
+
+    if (threads == 0) {
+        #ifdef _OPENMP
+        threads = omp_get_max_threads();
+        #else
+        threads = std::max(1u, std::thread::hardware_concurrency());
+        #endif
+    }
+
+    size_t workers = std::min<size_t>(threads, inputs.size());
+    int innerThreads = std::max<int>(1, threads / workers);
+
+    //  The local copy keeps the pool alive, even if a concurrent call with another number of workers replaces it
+    std::shared_ptr<ThreadPool> batchPool;
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (!pool || pool->size() != workers)
+            pool = std::make_shared<ThreadPool>(workers);
+        batchPool = pool;
+    }
+
+    std::vector<std::future<Ciphertext<DCRTPoly>>> futures;
+    for (const auto& input : inputs) {
+        futures.push_back(batchPool->submit([this, input, innerThreads]() {
+            //  The number of threads is an ICV of the calling thread, so it only limits the regions of this request
+            #ifdef _OPENMP
+            omp_set_num_threads(innerThreads);
+            #endif
+
+            return forward(input);
+        }));
+    }
+
+    std::vector<Ciphertext<DCRTPoly>> outputs;
+    for (auto& future : futures)
+        outputs.push_back(future.get());
+
+    return outputs;
+}
+
+
+std::vector<int> Application::getRotationIndices() {
+    return GetRotations(layers);
+}
+
+
+std::vector<std::shared_ptr<Operator>> Application::getLayers() {
+    return layers;
+}
+
+
+bool Application::isGraph() {
+    return graph != nullptr;
+}
+
+
+std::vector<LayerProfile> Application::getProfile() {
+    std::vector<LayerProfile> profiles;
+    for (const auto& layer : layers)
+        profiles.push_back(layer->getProfile());
+
+    return profiles;
+}
+
+
+void Application::resetProfile() {
+    for (const auto& layer : layers)
+        layer->resetProfile();
+}
+
+
+std::string Application::profileReport() {
+    return Profiler::report(getProfile());
+}
+
+
+/***
+ * Returns the layer as linear operator if it can be folded, nullptr otherwise.
+ */
+static std::shared_ptr<GeneralLinearOperator> foldable_linear(const std::shared_ptr<Operator>& layer) {
+    auto linear = std::dynamic_pointer_cast<GeneralLinearOperator>(layer);
+
+    return linear && linear->isFoldable() ? linear : nullptr;
+}
+
+
+/***
+ * Folds the layer into the last folded layer. Returns the layers that replace both, which is empty if both have to stay
+ * separate.
+ */
+static std::vector<std::shared_ptr<Operator>> fold_pair(const std::shared_ptr<Operator>& previous,
+                                                        const std::shared_ptr<Operator>& layer) {
+    auto previousLinear = foldable_linear(previous);
+    auto previousNorm = std::dynamic_pointer_cast<nn::BatchNorm>(previous);
+    auto linear = foldable_linear(layer);
+    auto norm = std::dynamic_pointer_cast<nn::BatchNorm>(layer);
+    auto square = std::dynamic_pointer_cast<nn::ScaledSquare>(layer);
+
+    if (previousLinear && norm)
+        return {previousLinear->foldOutputAffine(norm->getWeights(), norm->getBiases(), norm->getName())};
+
+    if (previousLinear && linear) {
+        auto composed = previousLinear->compose(*linear);
+        if (composed)
+            return {composed};
+
+        return {};
+    }
+
+    if (previousNorm && linear)
+        return {linear->foldInputAffine(previousNorm->getWeights(), previousNorm->getBiases(), previousNorm->getName())};
+
+    //  The scale and the shift of a x^2 + b x + c move into the linear operator, which saves the activation a level
+    if (previousLinear && square && square->getA() != 0 && !square->isNormalized()) {
+        double s, t;
+        auto normalized = square->normalized(s, t);
+
+        uint32_t batchSize = Operator::getContext()->GetEncodingParams()->GetBatchSize();
+        auto scaled = previousLinear->foldOutputAffine(std::vector<double>(batchSize, s),
+                                                       std::vector<double>(batchSize, t), square->getName());
+
+        return {scaled, normalized};
+    }
+
+    if (previousNorm && norm) {
+        //  norm(previousNorm(x)) = w2 * (w1 * x + b1) + b2
+        const auto& w1 = previousNorm->getWeights();
+        const auto& b1 = previousNorm->getBiases();
+        const auto& w2 = norm->getWeights();
+        const auto& b2 = norm->getBiases();
+
+        std::vector<double> weights(std::min(w1.size(), w2.size()));
+        std::vector<double> biases(std::max(std::min(b1.size(), w2.size()), b2.size()), .0);
+
+        for (size_t i = 0; i < weights.size(); i++)
+            weights[i] = w2[i] * w1[i];
+
+        for (size_t i = 0; i < biases.size(); i++)
+            biases[i] = (i < b1.size() && i < w2.size() ? w2[i] * b1[i] : .0) + (i < b2.size() ? b2[i] : .0);
+
+        return {std::make_shared<nn::BatchNorm>(weights, biases)};
+    }
+
+    return {};
+}
+
+
+std::vector<std::shared_ptr<Operator>> Application::fold(const std::vector<std::shared_ptr<Operator>>& layers) {
+    std::vector<std::shared_ptr<Operator>> result;
+
+    for (const auto& layer : layers) {
+        result.push_back(layer);
+
+        //  A folded layer might in turn fold into the layer before it, e.g. Gemm, BatchNorm, Gemm
+        while (result.size() > 1) {
+            auto folded = fold_pair(result[result.size() - 2], result.back());
+            if (folded.empty())
+                break;
+
+            if (Operator::getVerbosity()) {
+                std::cout << "Folded " << result[result.size() - 2]->getName() << " and " << result.back()->getName()
+                          << " into";
+                for (const auto& layer : folded)
+                    std::cout << " " << layer->getName();
+                std::cout << std::endl;
+            }
+
+            result.resize(result.size() - 2);
+            result.insert(result.end(), folded.begin(), folded.end());
+
+            //  Normalizing a ScaledSquare leaves two layers that do not fold any further
+            if (folded.size() > 1)
+                break;
+        }
+    }
+
+    return result;
+}
+
+
+BootstrapPlan Application::placeBootstraps(uint32_t inputLevels, uint32_t bootstrapLevels) {
+    if (graph) {
+        std::cerr << "Bootstraps can only be placed in a chain of layers, not in a graph." << std::endl;
+        exit(1);
+    }
+
+    const size_t n = layers.size();
+    const uint32_t maxLevels = std::max(inputLevels, bootstrapLevels);
+
+    std::vector<uint32_t> depths(n);
+    std::vector<bool> bootstrap(n);
+
+    for (size_t i = 0; i < n; i++) {
+        bootstrap[i] = std::dynamic_pointer_cast<BootStrapping>(layers[i]) != nullptr;
+        depths[i] = layers[i]->getDepth();
+
+        if (!bootstrap[i] && depths[i] > bootstrapLevels) {
+            std::cerr << layers[i]->getName() << " needs " << depths[i] << " levels, but only " << bootstrapLevels
+                      << " are left after bootstrapping." << std::endl;
+            exit(1);
+        }
+    }
+
+    //  cost[i][r]: fewest bootstraps for reaching layer i with r levels left
+    using Cost = uint64_t;
+    const Cost infinite = std::numeric_limits<uint64_t>::max();
+
+    std::vector<std::vector<Cost>> cost(n + 1, std::vector<Cost>(maxLevels + 1, infinite));
+    std::vector<std::vector<uint32_t>> from(n + 1, std::vector<uint32_t>(maxLevels + 1, 0));
+    std::vector<std::vector<bool>> inserted(n + 1, std::vector<bool>(maxLevels + 1, false));
+    cost[0][inputLevels] = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        for (uint32_t r = 0; r <= maxLevels; r++) {
+            if (cost[i][r] == infinite)
+                continue;
+
+            auto relax = [&](uint32_t left, Cost next, bool insert) {
+                if (next < cost[i + 1][left]) {
+                    cost[i + 1][left] = next;
+                    from[i + 1][left] = r;
+                    inserted[i + 1][left] = insert;
+                }
+            };
+
+            if (bootstrap[i]) {
+                relax(bootstrapLevels, cost[i][r] + 1, false);
+                continue;
+            }
+
+            if (r >= depths[i])
+                relax(r - depths[i], cost[i][r], false);
+
+            relax(bootstrapLevels - depths[i], cost[i][r] + 1, true);
+        }
+    }
+
+    uint32_t left = 0;
+    for (uint32_t r = 0; r <= maxLevels; r++)
+        if (cost[n][r] < cost[n][left] || (cost[n][r] == cost[n][left] && r > left))
+            left = r;
+
+    //  Walking the choices back from the end
+    std::vector<bool> insertBefore(n, false);
+    std::vector<uint32_t> levels(n + 1);
+    levels[n] = left;
+    for (size_t i = n; i > 0; i--) {
+        insertBefore[i - 1] = inserted[i][levels[i]];
+        levels[i - 1] = from[i][levels[i]];
+    }
+
+    BootstrapPlan plan;
+    std::vector<std::shared_ptr<Operator>> planned;
+
+    for (size_t i = 0; i < n; i++) {
+        if (insertBefore[i]) {
+            planned.push_back(std::make_shared<BootStrapping>());
+            plan.positions.push_back(i);
+            plan.names.push_back(planned.back()->getName());
+            plan.depths.push_back(0);
+            plan.levelsLeft.push_back(bootstrapLevels);
+            plan.bootstraps++;
+        }
+
+        if (bootstrap[i])
+            plan.bootstraps++;
+
+        planned.push_back(layers[i]);
+        plan.names.push_back(layers[i]->getName());
+        plan.depths.push_back(depths[i]);
+        plan.levelsLeft.push_back(levels[i + 1]);
+    }
+
+    layers = planned;
+
+    if (Operator::getVerbosity())
+        std::cout << plan.report();
+
+    return plan;
+}
+
+
+std::string BootstrapPlan::report() const {
+    std::ostringstream out;
+
+    out << std::left << std::setw(32) << "Layer" << std::right << std::setw(8) << "Depth" << std::setw(14)
+        << "Levels left" << std::endl;
+
+    for (size_t i = 0; i < names.size(); i++)
+        out << std::left << std::setw(32) << names[i] << std::right << std::setw(8) << depths[i] << std::setw(14)
+            << levelsLeft[i] << std::endl;
+
+    out << bootstraps << " bootstraps" << std::endl;
+
+    return out.str();
+}
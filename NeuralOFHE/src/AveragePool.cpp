@@ -1,10 +1,120 @@
 #include "NeuralOFHE/Operators/AveragePool.h"
+#include "LinTools.h"
 
 
 uint32_t nn::AveragePool::numAvgPool = 0;
 
 
-nn::AveragePool::AveragePool(matVec matrix) : 
-    GeneralLinearOperator(matrix, numAvgPool, "AvgPool_" + std::to_string(numAvgPool)) {
+nn::AveragePool::AveragePool(Tensor matrix) : 
+    GeneralLinearOperator(std::move(matrix), numAvgPool, "AvgPool_" + std::to_string(numAvgPool)) {
+    outputLayout = SlotLayout::dense(1, 1, weights.cols());
+}
+
+
+nn::AveragePool::AveragePool(Pool2DParams params) :
+    AveragePool(params, SlotLayout::dense(params.channels, params.height, params.width)) {
+
+}
+
+
+nn::AveragePool::AveragePool(Pool2DParams params, SlotLayout inputLayout) :
+    GeneralLinearOperator(numAvgPool, "AvgPool_" + std::to_string(numAvgPool)) {
+    this->params = params;
+    this->inputLayout = inputLayout;
+
+    uint32_t batchSize = context->GetEncodingParams()->GetBatchSize();
+
+    Conv2DParams window = {params.channels, params.channels, params.height, params.width, params.kernelHeight,
+                           params.kernelWidth, params.stride, params.padding};
+    outputLayout = convolution_output_layout(window, inputLayout, batchSize, name);
+
+    //  Without padding all windows lie inside of the image and have the same size. Rotate-and-sum leaves the sum of
+    //  every window at the slot of its anchor, which is only the output slot for a stride of 1. A larger stride
+    //  multiplexes the output, whose channels have to be moved by the depthwise convolution
+    if (params.padding == 0 && params.stride == 1) {
+        rotateAndSum = true;
+        return;
+    }
+
+    std::vector<double> kernel(params.channels * params.kernelHeight * params.kernelWidth, 1);
+    auto diagonals = convolution_diagonals(kernel, window, inputLayout, outputLayout, batchSize, true);
+
+    //  Every output is divided by the size of its window, which is smaller at the border if the padding does not count
+    for (uint32_t oy = 0; oy < outputLayout.height; oy++)
+        for (uint32_t ox = 0; ox < outputLayout.width; ox++) {
+            double size = params.kernelHeight * params.kernelWidth;
+
+            if (!params.countIncludePad) {
+                int64_t y = (int64_t) oy * params.stride - params.padding;
+                int64_t x = (int64_t) ox * params.stride - params.padding;
+
+                int64_t rows = std::min<int64_t>(y + params.kernelHeight, params.height) - std::max<int64_t>(y, 0);
+                int64_t cols = std::min<int64_t>(x + params.kernelWidth, params.width) - std::max<int64_t>(x, 0);
+                size = rows * cols;
+            }
+
+            for (uint32_t c = 0; c < outputLayout.channels; c++) {
+                uint32_t out = outputLayout.slot(c, oy, ox);
+
+                for (auto& diagonal : diagonals)
+                    diagonal.second[out] /= size;
+            }
+        }
+
+    schedule = std::make_shared<DiagonalSchedule>(
+            make_diagonal_schedule(std::move(diagonals), batchSize, outputLayout.size()));
+}
+
+
+Ciphertext<DCRTPoly> nn::AveragePool::forward(Ciphertext<DCRTPoly> x) {
+    if (!rotateAndSum)
+        return GeneralLinearOperator::forward(x);
+
+    //  Summing up the columns of every window and afterwards its rows. Both stay within the channel of the window
+    x = rotate_and_sum(x, params.kernelWidth, inputLayout.gap, context);
+    x = rotate_and_sum(x, params.kernelHeight, inputLayout.gap * inputLayout.rowPitch, context);
+    x = context->EvalMult(x, 1. / (params.kernelHeight * params.kernelWidth));
+    Profiler::count(&LayerProfile::scalarMults);
+
+    store_output_size(x, outputLayout.size());
+
+    return x;
+}
+
+
+void nn::AveragePool::warmUp(uint32_t level) {
+    if (!rotateAndSum)
+        GeneralLinearOperator::warmUp(level);
+}
+
+
+std::vector<int> nn::AveragePool::getRotationIndices() {
+    if (!rotateAndSum)
+        return GeneralLinearOperator::getRotationIndices();
+
+    uint32_t batchSize = context->GetEncodingParams()->GetBatchSize();
+
+    std::vector<int> columns = rotate_and_sum_rotations(params.kernelWidth, inputLayout.gap, batchSize);
+    std::vector<int> rows = rotate_and_sum_rotations(params.kernelHeight, inputLayout.gap * inputLayout.rowPitch,
+                                                     batchSize);
+
+    std::set<int> rotations(columns.begin(), columns.end());
+    rotations.insert(rows.begin(), rows.end());
+
+    return std::vector<int>(rotations.begin(), rotations.end());
+}
+
+
+uint32_t nn::AveragePool::getOutputSize() {
+    return outputLayout.size();
+}
+
+
+nn::SlotLayout nn::AveragePool::getOutputLayout() {
+    return outputLayout;
+}
+
 
+std::vector<uint32_t> nn::AveragePool::getOutputSlots() {
+    return outputLayout.slots();
 }
@@ -1,4 +1,5 @@
 #include "NeuralOFHE/Operators/BatchNorm.h"
+#include "PlaintextCache.h"
 
 uint32_t nn::BatchNorm::numBatchNorm = 0;
 
@@ -9,11 +10,29 @@ nn::BatchNorm::BatchNorm(std::vector<double> weights, std::vector<double> bias)
 }
 
 Ciphertext<DCRTPoly> nn::BatchNorm::forward(Ciphertext<DCRTPoly> x) {
-    Plaintext pl_weight = context->MakeCKKSPackedPlaintext(weights);
-    Plaintext pl_biases = context->MakeCKKSPackedPlaintext(biases);
-
+    Plaintext pl_weight = cache->get(0, weights, x, context);
     Ciphertext<DCRTPoly> result = context->EvalMult(pl_weight, x);
+    Profiler::count(&LayerProfile::plainMults);
+
+    Plaintext pl_biases = cache->get(PlaintextCache::BIAS_INDEX, biases, result, context);
     result = context->EvalAdd(pl_biases, result);
 
     return result;
 }
+
+void nn::BatchNorm::warmUp(uint32_t level) {
+    cache->warmUp({{0, &weights}}, level, context);
+    cache->warmUp({{PlaintextCache::BIAS_INDEX, &biases}}, PlaintextCache::productLevel(level, context), context);
+}
+
+uint32_t nn::BatchNorm::getDepth() {
+    return 1;
+}
+
+const std::vector<double>& nn::BatchNorm::getWeights() {
+    return weights;
+}
+
+const std::vector<double>& nn::BatchNorm::getBiases() {
+    return biases;
+}
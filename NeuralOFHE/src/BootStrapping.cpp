@@ -1,13 +1,19 @@
 #include "../include/NeuralOFHE/Operators/BootStrapping.h"
+#include "NeuralOFHE/Tracer.h"
 
 
-BootStrapping::BootStrapping() : Operator() {
+uint32_t BootStrapping::numBootStrap = 0;
+
+
+BootStrapping::BootStrapping() : Operator(numBootStrap, "BootStrapping_" + std::to_string(numBootStrap)) {
 
 }
 
 
 Ciphertext<DCRTPoly> BootStrapping::forward(Ciphertext<lbcrypto::DCRTPoly> x) {
+    Tracer::Span span("openfhe", "EvalBootstrap");
     Ciphertext<DCRTPoly> res = context->EvalBootstrap(x);
+    Profiler::count(&LayerProfile::bootstraps);
 
     return res;
 }
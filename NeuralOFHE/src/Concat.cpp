@@ -0,0 +1,117 @@
+#include "NeuralOFHE/Operators/Concat.h"
+#include "NeuralOFHE/Tracer.h"
+#include "LinTools.h"
+
+#include <algorithm>
+
+uint32_t nn::Concat::numConcat = 0;
+
+
+nn::Concat::Concat(std::vector<uint32_t> sizes, bool mask) :
+    MultiInputOperator(numConcat, "Concat_" + std::to_string(numConcat)) {
+    uint32_t batchSize = context->GetEncodingParams()->GetBatchSize();
+
+    if (sizes.empty()) {
+        std::cerr << name << ": Nothing to concatenate." << std::endl;
+        exit(1);
+    }
+
+    uint32_t offset = 0;
+    for (uint32_t size : sizes) {
+        offsets.push_back(offset);
+        offset += size;
+    }
+
+    if (offset > batchSize) {
+        std::cerr << name << ": Concatenation of " << offset << " slots does not fit into the batch size "
+                  << batchSize << "." << std::endl;
+        exit(1);
+    }
+
+    this->sizes = std::move(sizes);
+
+    if (!mask)
+        return;
+
+    for (size_t i = 0; i < this->sizes.size(); i++) {
+        masks.emplace_back(offset, .0);
+        std::fill_n(masks.back().begin() + offsets[i], this->sizes[i], 1.);
+    }
+}
+
+
+Ciphertext<DCRTPoly> nn::Concat::forward(const std::vector<Ciphertext<DCRTPoly>>& inputs) {
+    uint32_t batchSize = context->GetEncodingParams()->GetBatchSize();
+
+    if (inputs.size() != sizes.size()) {
+        std::cerr << name << ": Expected " << sizes.size() << " inputs, got " << inputs.size() << "." << std::endl;
+        exit(1);
+    }
+
+    std::vector<Ciphertext<DCRTPoly>> parts(inputs.size());
+
+    //  Counted beforehand, as the loop runs on OpenMP threads
+    uint64_t rotations = std::count_if(offsets.begin(), offsets.end(), [](uint32_t offset) { return offset != 0; });
+    Profiler::count(&LayerProfile::rotations, rotations);
+    Profiler::count(&LayerProfile::keySwitches, rotations);
+    Profiler::count(&LayerProfile::plainMults, masks.empty() ? 0 : inputs.size());
+
+    //  Every input is rotated and masked on its own, only the sum needs all of them
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < inputs.size(); i++) {
+        Tracer::Span span("concat", "input", i);
+        Ciphertext<DCRTPoly> part = inputs[i];
+
+        if (offsets[i] != 0)
+            part = context->EvalRotate(part, batchSize - offsets[i]);
+
+        if (!masks.empty())
+            part = context->EvalMult(part, cache->get(i, masks[i], part, context));
+
+        parts[i] = part;
+    }
+
+    Ciphertext<DCRTPoly> result = parts[0];
+    for (size_t i = 1; i < parts.size(); i++)
+        result = context->EvalAdd(result, parts[i]);
+
+    store_output_size(result, getOutputSize());
+
+    return result;
+}
+
+
+size_t nn::Concat::getNumInputs() {
+    return sizes.size();
+}
+
+
+void nn::Concat::warmUp(uint32_t level) {
+    std::vector<std::pair<uint32_t, const std::vector<double>*>> entries;
+    for (size_t i = 0; i < masks.size(); i++)
+        entries.push_back({(uint32_t) i, &masks[i]});
+
+    cache->warmUp(entries, level, context);
+}
+
+
+std::vector<int> nn::Concat::getRotationIndices() {
+    uint32_t batchSize = context->GetEncodingParams()->GetBatchSize();
+
+    std::set<int> rotations;
+    for (uint32_t offset : offsets)
+        if (offset != 0)
+            rotations.insert(batchSize - offset);
+
+    return std::vector<int>(rotations.begin(), rotations.end());
+}
+
+
+uint32_t nn::Concat::getDepth() {
+    return masks.empty() ? 0 : 1;
+}
+
+
+uint32_t nn::Concat::getOutputSize() {
+    return offsets.empty() ? 0 : offsets.back() + sizes.back();
+}
@@ -1,8 +1,56 @@
 #include "NeuralOFHE/Operators/Conv2D.h"
+#include "LinTools.h"
 
 uint32_t nn::Conv2D::numConv = 0;
 
 
-nn::Conv2D::Conv2D(std::vector<std::vector<double>> weights, std::vector<double> bias) : GeneralLinearOperator(weights, bias, numConv, "Conv2D_" +  std::to_string(numConv)) {
+nn::Conv2D::Conv2D(Tensor weights, std::vector<double> bias) : GeneralLinearOperator(std::move(weights), std::move(bias), numConv, "Conv2D_" +  std::to_string(numConv)) {
+    outputLayout = SlotLayout::dense(1, 1, this->weights.cols());
+}
+
+
+nn::Conv2D::Conv2D(std::vector<double> kernel, std::vector<double> bias, Conv2DParams params) :
+    Conv2D(kernel, bias, params, SlotLayout::dense(params.inChannels, params.height, params.width)) {
+
+}
+
+
+nn::Conv2D::Conv2D(std::vector<double> kernel, std::vector<double> bias, Conv2DParams params, SlotLayout inputLayout) :
+    GeneralLinearOperator(numConv, "Conv2D_" +  std::to_string(numConv)) {
+    uint32_t batchSize = context->GetEncodingParams()->GetBatchSize();
+
+    if (kernel.size() != (size_t) params.outChannels * params.inChannels * params.kernelHeight * params.kernelWidth) {
+        std::cerr << name << ": Kernel has " << kernel.size() << " entries, expected " << params.outChannels << "x"
+                  << params.inChannels << "x" << params.kernelHeight << "x" << params.kernelWidth << "." << std::endl;
+        exit(1);
+    }
+
+    if (!bias.empty() && bias.size() != params.outChannels) {
+        std::cerr << name << ": Expected one bias per output channel, got " << bias.size() << "." << std::endl;
+        exit(1);
+    }
+
+    outputLayout = convolution_output_layout(params, inputLayout, batchSize, name);
+
+    schedule = std::make_shared<DiagonalSchedule>(make_diagonal_schedule(
+            convolution_diagonals(kernel, params, inputLayout, outputLayout, batchSize), batchSize, outputLayout.size()));
+
+    if (!bias.empty()) {
+        biases.assign(outputLayout.size(), 0);
+
+        for (uint32_t co = 0; co < outputLayout.channels; co++)
+            for (uint32_t oy = 0; oy < outputLayout.height; oy++)
+                for (uint32_t ox = 0; ox < outputLayout.width; ox++)
+                    biases[outputLayout.slot(co, oy, ox)] = bias[co];
+    }
+}
+
+
+nn::SlotLayout nn::Conv2D::getOutputLayout() {
+    return outputLayout;
+}
+
 
+std::vector<uint32_t> nn::Conv2D::getOutputSlots() {
+    return outputLayout.slots();
 }
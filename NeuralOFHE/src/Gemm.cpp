@@ -3,6 +3,6 @@
 uint32_t nn::Gemm::numGemm = 0;
 
 
-nn::Gemm::Gemm(matVec matrix, std::vector<double> bias) : GeneralLinearOperator(matrix, bias, numGemm, "Gemm_" + std::to_string(numGemm)) {
+nn::Gemm::Gemm(Tensor matrix, std::vector<double> bias) : GeneralLinearOperator(std::move(matrix), std::move(bias), numGemm, "Gemm_" + std::to_string(numGemm)) {
 
 }
@@ -2,22 +2,228 @@
 #include "LinTools.h"
 
 
-GeneralLinearOperator::GeneralLinearOperator(matVec weights, unsigned int& objCounter, std::string name) : Operator(objCounter, name) {
-    this->weights = weights;
+GeneralLinearOperator::GeneralLinearOperator(Tensor weights, unsigned int& objCounter, std::string name) : Operator(objCounter, name) {
+    this->weights = std::move(weights);
+
+    uint32_t batchSize = context->GetEncodingParams()->GetBatchSize();
+    schedule = std::make_shared<DiagonalSchedule>(make_diagonal_schedule(this->weights, batchSize));
 }
 
-GeneralLinearOperator::GeneralLinearOperator(matVec weights, std::vector<double> biases, unsigned int& objCounter, std::string name) : Operator(objCounter, name) {
-    this->weights = weights;
-    this->biases = biases;
+GeneralLinearOperator::GeneralLinearOperator(Tensor weights, std::vector<double> biases, unsigned int& objCounter, std::string name) : Operator(objCounter, name) {
+    this->weights = std::move(weights);
+    this->biases = std::move(biases);
+
+    uint32_t batchSize = context->GetEncodingParams()->GetBatchSize();
+    schedule = std::make_shared<DiagonalSchedule>(make_diagonal_schedule(this->weights, batchSize));
+}
+
+GeneralLinearOperator::GeneralLinearOperator(unsigned int& objCounter, std::string name) : Operator(objCounter, name) {
+
 }
 
 Ciphertext<DCRTPoly> GeneralLinearOperator::forward(Ciphertext<lbcrypto::DCRTPoly> x) {
-    x = matrix_multiplication(weights, x, context);
+    x = matrix_multiplication(*schedule, x, context, true, cache.get());
 
     if (biases.size() != 0) {
-        Plaintext pl = context->MakeCKKSPackedPlaintext(biases);
+        Plaintext pl = cache->get(PlaintextCache::BIAS_INDEX, biases, x, context);
         x = context->EvalAdd(x, pl);
     }
 
     return x;
 }
+
+void GeneralLinearOperator::warmUp(uint32_t level) {
+    std::vector<std::pair<uint32_t, const std::vector<double>*>> entries;
+    for (size_t i=0; i<schedule->diagonals.size(); i++)
+        entries.push_back({schedule->offsets[i], &schedule->diagonals[i]});
+
+    //  The double hoisted engine looks up the diagonals encoded in the extended basis QP
+    cache->warmUp(entries, level, context, get_default_engine() == MatMulEngine::DOUBLE_HOISTED);
+
+    //  The bias is added to the product of the diagonals
+    if (!biases.empty())
+        cache->warmUp({{PlaintextCache::BIAS_INDEX, &biases}}, PlaintextCache::productLevel(level, context), context);
+}
+
+std::vector<int> GeneralLinearOperator::getRotationIndices() {
+    return schedule_rotations(*schedule);
+}
+
+uint32_t GeneralLinearOperator::getDepth() {
+    return 1;
+}
+
+uint32_t GeneralLinearOperator::getOutputSize() {
+    return schedule ? schedule->outputSize : 0;
+}
+
+uint32_t GeneralLinearOperator::numFolded = 0;
+
+
+/***
+ * Entry i of a vector that is padded with zeros.
+ */
+static double entry(const std::vector<double>& vector, size_t i) {
+    return i < vector.size() ? vector[i] : .0;
+}
+
+
+bool GeneralLinearOperator::isFoldable() {
+    return schedule != nullptr;
+}
+
+std::shared_ptr<GeneralLinearOperator> GeneralLinearOperator::foldOutputAffine(const std::vector<double>& scale,
+                                                                               const std::vector<double>& shift,
+                                                                               const std::string& foldedName) {
+    uint32_t batchSize = context->GetEncodingParams()->GetBatchSize();
+    std::shared_ptr<GeneralLinearOperator> result(new GeneralLinearOperator(numFolded, name + "+" + foldedName));
+
+    if (!weights.empty()) {
+        size_t rows = weights.rows();
+        size_t cols = weights.cols();
+        std::vector<double> values(rows * cols);
+
+        #pragma omp parallel for schedule(static)
+        for (size_t c = 0; c < rows; c++)
+            for (size_t r = 0; r < cols; r++)
+                values[c * cols + r] = weights(c, r) * entry(scale, r);
+
+        result->weights = Tensor({rows, cols}, std::move(values));
+        result->schedule = std::make_shared<DiagonalSchedule>(make_diagonal_schedule(result->weights, batchSize));
+    } else {
+        auto diagonals = schedule_diagonals(*schedule);
+
+        for (auto& diagonal : diagonals)
+            for (uint32_t r = 0; r < batchSize; r++)
+                diagonal.second[r] *= entry(scale, r);
+
+        result->schedule = std::make_shared<DiagonalSchedule>(
+                make_diagonal_schedule(std::move(diagonals), batchSize, schedule->outputSize));
+    }
+
+    result->biases.resize(std::max(biases.size(), shift.size()));
+    for (size_t r = 0; r < result->biases.size(); r++)
+        result->biases[r] = entry(scale, r) * entry(biases, r) + entry(shift, r);
+
+    return result;
+}
+
+std::shared_ptr<GeneralLinearOperator> GeneralLinearOperator::foldInputAffine(const std::vector<double>& scale,
+                                                                              const std::vector<double>& shift,
+                                                                              const std::string& foldedName) {
+    uint32_t batchSize = context->GetEncodingParams()->GetBatchSize();
+    std::shared_ptr<GeneralLinearOperator> result(new GeneralLinearOperator(numFolded, foldedName + "+" + name));
+
+    if (!weights.empty()) {
+        size_t rows = weights.rows();
+        size_t cols = weights.cols();
+        std::vector<double> values(rows * cols);
+
+        #pragma omp parallel for schedule(static)
+        for (size_t c = 0; c < rows; c++)
+            for (size_t r = 0; r < cols; r++)
+                values[c * cols + r] = entry(scale, c) * weights(c, r);
+
+        //  The shift passes through the unscaled weights, entries beyond the input size are never read
+        result->biases.assign(std::max<size_t>(biases.size(), cols), .0);
+        for (size_t r = 0; r < result->biases.size(); r++)
+            result->biases[r] = entry(biases, r);
+
+        for (size_t c = 0; c < std::min(rows, shift.size()); c++)
+            for (size_t r = 0; r < cols; r++)
+                result->biases[r] += shift[c] * weights(c, r);
+
+        result->weights = Tensor({rows, cols}, std::move(values));
+        result->schedule = std::make_shared<DiagonalSchedule>(make_diagonal_schedule(result->weights, batchSize));
+    } else {
+        auto diagonals = schedule_diagonals(*schedule);
+
+        result->biases = apply_diagonals(diagonals, shift, batchSize);
+        for (size_t r = 0; r < biases.size(); r++)
+            result->biases[r] += biases[r];
+
+        for (auto& diagonal : diagonals)
+            for (uint32_t r = 0; r < batchSize; r++)
+                diagonal.second[r] *= entry(scale, (r + diagonal.first) % batchSize);
+
+        result->schedule = std::make_shared<DiagonalSchedule>(
+                make_diagonal_schedule(std::move(diagonals), batchSize, schedule->outputSize));
+    }
+
+    return result;
+}
+
+std::shared_ptr<GeneralLinearOperator> GeneralLinearOperator::compose(GeneralLinearOperator& next) {
+    uint32_t batchSize = context->GetEncodingParams()->GetBatchSize();
+
+    size_t separateCost = schedule_cost(schedule->offsets, batchSize, schedule->reductions.size())
+                          + schedule_cost(next.schedule->offsets, batchSize, next.schedule->reductions.size());
+
+    std::shared_ptr<GeneralLinearOperator> result(new GeneralLinearOperator(numFolded, name + "+" + next.name));
+
+    if (!weights.empty() && !next.weights.empty()) {
+        //  Both matrices are of shape input size x output size, so the composition is weights * next.weights. Outputs
+        //  of this operator beyond the input size of next are never read
+        size_t rows = weights.rows();
+        size_t inner = std::min(weights.cols(), next.weights.rows());
+        size_t cols = next.weights.cols();
+        std::vector<double> values(rows * cols, .0);
+
+        #pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < rows; i++) {
+            double* row = values.data() + i * cols;
+
+            for (size_t l = 0; l < inner; l++) {
+                double factor = weights(i, l);
+                if (factor == .0)
+                    continue;
+
+                const double* nextRow = next.weights.row(l);
+                for (size_t j = 0; j < cols; j++)
+                    row[j] += factor * nextRow[j];
+            }
+        }
+
+        result->weights = Tensor({rows, cols}, std::move(values));
+        result->schedule = std::make_shared<DiagonalSchedule>(make_diagonal_schedule(result->weights, batchSize));
+
+        if (schedule_cost(result->schedule->offsets, batchSize, result->schedule->reductions.size()) > separateCost)
+            return nullptr;
+
+        result->biases.assign(std::max<size_t>(next.biases.size(), cols), .0);
+        for (size_t j = 0; j < result->biases.size(); j++)
+            result->biases[j] = entry(next.biases, j);
+
+        //  The biases of this operator are added before next, so they pass through all of its input slots
+        for (size_t l = 0; l < std::min(biases.size(), next.weights.rows()); l++)
+            for (size_t j = 0; j < cols; j++)
+                result->biases[j] += biases[l] * next.weights(l, j);
+
+        return result;
+    }
+
+    auto first = schedule->reductions.empty() ? schedule_diagonals(*schedule) : banded_diagonals(weights, batchSize);
+    auto second = next.schedule->reductions.empty() ? schedule_diagonals(*next.schedule)
+                                                    : banded_diagonals(next.weights, batchSize);
+
+    //  Every pair of diagonals costs a pass over all slots, which is only affordable for sparse maps like convolutions
+    if (first.size() * second.size() > batchSize)
+        return nullptr;
+
+    std::set<unsigned int> offsets;
+    for (const auto& b : second)
+        for (const auto& a : first)
+            offsets.insert((b.first + a.first) % batchSize);
+
+    if (schedule_cost(std::vector<unsigned int>(offsets.begin(), offsets.end()), batchSize) > separateCost)
+        return nullptr;
+
+    result->biases = apply_diagonals(second, biases, batchSize);
+    for (size_t r = 0; r < next.biases.size(); r++)
+        result->biases[r] += next.biases[r];
+
+    result->schedule = std::make_shared<DiagonalSchedule>(make_diagonal_schedule(
+            compose_diagonals(first, second, batchSize), batchSize, next.schedule->outputSize));
+
+    return result;
+}
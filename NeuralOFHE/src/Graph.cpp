@@ -0,0 +1,213 @@
+#include "NeuralOFHE/Graph.h"
+#include "NeuralOFHE/Helperfunctions/HelperFunctions.h"
+
+#include <algorithm>
+#include <atomic>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+size_t Graph::addInput() {
+    inputNodes.push_back(nodes.size());
+    nodes.push_back({nullptr, nullptr, {}, 0});
+
+    return nodes.size() - 1;
+}
+
+
+size_t Graph::addNode(std::shared_ptr<Operator> op, size_t input) {
+    return addNode({op, std::dynamic_pointer_cast<MultiInputOperator>(op), {input}, 0});
+}
+
+
+size_t Graph::addNode(std::shared_ptr<MultiInputOperator> op, std::vector<size_t> inputs) {
+    if (op->getNumInputs() != 0 && op->getNumInputs() != inputs.size()) {
+        std::cerr << op->getName() << ": Expected " << op->getNumInputs() << " inputs, got " << inputs.size() << "."
+                  << std::endl;
+        exit(1);
+    }
+
+    return addNode({op, op, std::move(inputs), 0});
+}
+
+
+size_t Graph::addNode(Node node) {
+    if (node.inputs.empty()) {
+        std::cerr << node.op->getName() << ": A node needs at least one input." << std::endl;
+        exit(1);
+    }
+
+    for (size_t input : node.inputs) {
+        if (input >= nodes.size()) {
+            std::cerr << node.op->getName() << ": Input " << input << " has not been added to the graph yet."
+                      << std::endl;
+            exit(1);
+        }
+
+        node.wavefront = std::max(node.wavefront, nodes[input].wavefront + 1);
+    }
+
+    //  Without nested parallelism the regions of the operators within the nodes of a wavefront would run on a single
+    //  thread each. The limit is raised once here rather than in forward, since it is shared by all threads and
+    //  concurrent forward passes would otherwise reset it for each other
+    #ifdef _OPENMP
+    if (omp_get_max_active_levels() < 2)
+        omp_set_max_active_levels(2);
+    #endif
+
+    nodes.push_back(std::move(node));
+
+    return nodes.size() - 1;
+}
+
+
+void Graph::addOutput(size_t node) {
+    if (node >= nodes.size()) {
+        std::cerr << "Output " << node << " has not been added to the graph yet." << std::endl;
+        exit(1);
+    }
+
+    outputNodes.push_back(node);
+}
+
+
+std::vector<Ciphertext<DCRTPoly>> Graph::forward(const std::vector<Ciphertext<DCRTPoly>>& inputs) {
+    if (inputs.size() != inputNodes.size()) {
+        std::cerr << "Graph expects " << inputNodes.size() << " inputs, got " << inputs.size() << "." << std::endl;
+        exit(1);
+    }
+
+    const size_t n = nodes.size();
+
+    //  Consumers that still have to read a node, outputs count as one more consumer so that they are never released
+    std::unique_ptr<std::atomic<size_t>[]> pending(new std::atomic<size_t>[n]);
+    for (size_t i = 0; i < n; i++)
+        pending[i] = 0;
+
+    for (const auto& node : nodes)
+        for (size_t input : node.inputs)
+            pending[input]++;
+
+    for (size_t output : outputNodes)
+        pending[output]++;
+
+    std::vector<std::vector<size_t>> wavefronts;
+    for (size_t i = 0; i < n; i++) {
+        if (nodes[i].op == nullptr)
+            continue;
+
+        if (wavefronts.size() < nodes[i].wavefront)
+            wavefronts.resize(nodes[i].wavefront);
+        wavefronts[nodes[i].wavefront - 1].push_back(i);
+    }
+
+    std::vector<Ciphertext<DCRTPoly>> values(n);
+    std::atomic<size_t> live(0);
+    std::atomic<size_t> peak(0);
+
+    auto raisePeak = [&](size_t current) {
+        size_t previous = peak.load();
+        while (current > previous && !peak.compare_exchange_weak(previous, current));
+    };
+
+    for (size_t i = 0; i < inputNodes.size(); i++) {
+        if (pending[inputNodes[i]] == 0)
+            continue;
+
+        values[inputNodes[i]] = inputs[i];
+        raisePeak(++live);
+    }
+
+    #ifdef _OPENMP
+    int cores = omp_get_max_threads();
+    #else
+    int cores = 1;
+    #endif
+
+    for (const auto& wavefront : wavefronts) {
+        //  Operators parallelize internally as well, so the cores are split between the nodes of the wavefront and
+        //  every node runs the loops of its operator with its share. A single node keeps all threads to itself
+        int branches = std::max(std::min<int>(wavefront.size(), cores), 1);
+        int threadsPerBranch = std::max(cores / branches, 1);
+
+        #pragma omp parallel for schedule(dynamic) num_threads(branches) if(branches > 1)
+        for (size_t k = 0; k < wavefront.size(); k++) {
+            const Node& node = nodes[wavefront[k]];
+
+            #ifdef _OPENMP
+            if (branches > 1)
+                omp_set_num_threads(threadsPerBranch);
+            #endif
+
+            Ciphertext<DCRTPoly> result;
+            if (node.multiInput) {
+                std::vector<Ciphertext<DCRTPoly>> arguments;
+                for (size_t input : node.inputs)
+                    arguments.push_back(values[input]);
+
+                result = node.multiInput->evaluate(arguments);
+            } else {
+                result = node.op->evaluate(values[node.inputs[0]]);
+            }
+
+            values[wavefront[k]] = result;
+            raisePeak(++live);
+
+            //  The last consumer of an input releases it
+            for (size_t input : node.inputs) {
+                if (--pending[input] == 0) {
+                    values[input] = nullptr;
+                    live--;
+                }
+            }
+        }
+
+        //  Nodes nobody consumes are released right away
+        for (size_t i : wavefront) {
+            if (pending[i] == 0) {
+                values[i] = nullptr;
+                live--;
+            }
+        }
+    }
+
+    peakLive = peak.load();
+
+    std::vector<Ciphertext<DCRTPoly>> outputs;
+    for (size_t output : outputNodes)
+        outputs.push_back(values[output]);
+
+    return outputs;
+}
+
+
+Ciphertext<DCRTPoly> Graph::forward(Ciphertext<DCRTPoly> x) {
+    if (outputNodes.size() != 1) {
+        std::cerr << "Graph has " << outputNodes.size() << " outputs, expected exactly one." << std::endl;
+        exit(1);
+    }
+
+    return forward(std::vector<Ciphertext<DCRTPoly>>{x})[0];
+}
+
+
+std::vector<std::shared_ptr<Operator>> Graph::getOperators() {
+    std::vector<std::shared_ptr<Operator>> operators;
+    for (const auto& node : nodes)
+        if (node.op)
+            operators.push_back(node.op);
+
+    return operators;
+}
+
+
+std::vector<int> Graph::getRotationIndices() {
+    return GetRotations(getOperators());
+}
+
+
+size_t Graph::getPeakLiveCiphertexts() {
+    return peakLive;
+}
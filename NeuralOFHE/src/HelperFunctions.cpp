@@ -1,4 +1,6 @@
 #include "NeuralOFHE/Helperfunctions/HelperFunctions.h"
+#include "PlaintextCache.h"
+#include "LinTools.h"
 
 
 void SetContext(CryptoContext<DCRTPoly> context) {
@@ -6,6 +8,16 @@ void SetContext(CryptoContext<DCRTPoly> context) {
 }
 
 
+void SetPlaintextCacheBudget(size_t bytes) {
+    PlaintextCache::setDefaultBudget(bytes);
+}
+
+
+void SetDoubleHoisting(bool enabled) {
+    set_default_engine(enabled ? MatMulEngine::DOUBLE_HOISTED : MatMulEngine::HOISTED);
+}
+
+
 std::vector<int> GetRotations (uint32_t batchSize) {
     std::set<int> resultSet;
 
@@ -33,3 +45,15 @@ std::vector<int> GetRotations (uint32_t batchSize) {
 
     return result;
 }
+
+
+std::vector<int> GetRotations (const std::vector<std::shared_ptr<Operator>>& layers) {
+    std::set<int> resultSet;
+
+    for (const auto& layer : layers) {
+        std::vector<int> rotations = layer->getRotationIndices();
+        resultSet.insert(rotations.begin(), rotations.end());
+    }
+
+    return std::vector<int>(resultSet.begin(), resultSet.end());
+}
@@ -1,4 +1,141 @@
 #include "LinTools.h"
+#include "NeuralOFHE/Profiler.h"
+#include "NeuralOFHE/Tracer.h"
+#include <algorithm>
+#include <atomic>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+//  Read by concurrent forward passes, while SetDoubleHoisting may change it
+static std::atomic<MatMulEngine> defaultEngine{MatMulEngine::HOISTED};
+
+
+/***
+ * Encodes a diagonal of a schedule at the level of the ciphertext it is multiplied with, using the cache if one is given.
+ */
+static Plaintext encode_diagonal(unsigned int index, const std::vector<double>& diagonal, const Ciphertext<DCRTPoly>& vector,
+                                 const CryptoContext<DCRTPoly>& context, PlaintextCache* cache) {
+    if (cache)
+        return cache->get(index, diagonal, vector, context);
+
+    return PlaintextCache::encode(diagonal, PlaintextCache::multiplicationLevel(vector, context), context);
+}
+
+
+/***
+ * Encodes a diagonal of a schedule in the extended basis QP for a multiplication with mult_extended.
+ */
+static Plaintext encode_extended_diagonal(unsigned int index, const std::vector<double>& diagonal,
+                                          const Ciphertext<DCRTPoly>& vector, const CryptoContext<DCRTPoly>& context,
+                                          PlaintextCache* cache) {
+    if (cache)
+        return cache->get(index, diagonal, vector, context, true);
+
+    return PlaintextCache::encodeExtended(diagonal, PlaintextCache::multiplicationLevel(vector, context), context);
+}
+
+
+/***
+ * Multiplies a ciphertext in the extended basis QP with a plaintext that is encoded in the same basis. CryptoContext
+ * has no public method for this, as it expects all ciphertexts to be in basis Q.
+ */
+static Ciphertext<DCRTPoly> mult_extended(const Ciphertext<DCRTPoly>& ciphertext, const Plaintext& plaintext) {
+    Ciphertext<DCRTPoly> result = ciphertext->Clone();
+
+    DCRTPoly element = plaintext->GetElement<DCRTPoly>();
+    element.SetFormat(Format::EVALUATION);
+
+    for (auto& c : result->GetElements())
+        c *= element;
+
+    result->SetNoiseScaleDeg(result->GetNoiseScaleDeg() + plaintext->GetNoiseScaleDeg());
+    result->SetScalingFactor(result->GetScalingFactor() * plaintext->GetScalingFactor());
+
+    return result;
+}
+
+
+/***
+ * Adds the elements of b to those of a, both in the same basis. a is changed in place.
+ */
+static void add_extended_in_place(Ciphertext<DCRTPoly>& a, const Ciphertext<DCRTPoly>& b) {
+    auto& elementsA = a->GetElements();
+    const auto& elementsB = b->GetElements();
+
+    for (size_t i=0; i<elementsA.size(); i++)
+        elementsA[i] += elementsB[i];
+}
+
+
+/***
+ * Partial sum of the double hoisted matrix multiplication. The first elements of the giant steps are already in basis Q
+ * and summed up separately, the rest stays in the extended basis QP until the end.
+ */
+struct ExtendedSum {
+    Ciphertext<DCRTPoly> extended;
+    DCRTPoly first;
+
+    void add(const Ciphertext<DCRTPoly>& otherExtended, const DCRTPoly& otherFirst) {
+        if (extended) {
+            add_extended_in_place(extended, otherExtended);
+            first += otherFirst;
+        } else {
+            extended = otherExtended;
+            first = otherFirst;
+        }
+    }
+};
+
+
+/***
+ * Evaluates one giant step of the double hoisted matrix multiplication and adds it to sum. rotCache holds the baby
+ * steps in the extended basis.
+ */
+static void double_hoisted_giant_step(const DiagonalSchedule& schedule, const GiantStep& giantStep,
+                                      const std::vector<Ciphertext<DCRTPoly>>& rotCache,
+                                      const Ciphertext<DCRTPoly>& vector, const CryptoContext<DCRTPoly>& context,
+                                      PlaintextCache* cache, ExtendedSum& sum) {
+    Tracer::Span span("bsgs", "giant step", giantStep.rotation);
+
+    Ciphertext<DCRTPoly> inner;
+
+    for (const auto& term : giantStep.terms) {
+        size_t d = term.second;
+        Plaintext pl = encode_extended_diagonal(schedule.offsets[d], schedule.diagonals[d], vector, context, cache);
+        Ciphertext<DCRTPoly> product = mult_extended(rotCache[term.first], pl);
+
+        if (inner)
+            add_extended_in_place(inner, product);
+        else
+            inner = product;
+    }
+
+    DCRTPoly first;
+
+    if (giantStep.rotation == 0) {
+        //  Without a rotation, only the first element has to be brought back to Q right away
+        first = context->KeySwitchDownFirstElement(inner);
+        inner->GetElements()[0].SetValuesToZero();
+    } else {
+        //  The first element is rotated by an automorphism, which needs no key switch. The second one is key switched
+        //  by a hoisted rotation whose result stays in QP
+        inner = context->KeySwitchDown(inner);
+
+        uint32_t N = context->GetRingDimension();
+        usint autoIndex = FindAutomorphismIndex2nComplex(giantStep.rotation, 2 * N);
+        std::vector<usint> map(N);
+        PrecomputeAutoMap(N, autoIndex, &map);
+        first = inner->GetElements()[0].AutomorphismTransform(autoIndex, map);
+
+        auto innerPrecompute = context->EvalFastRotationPrecompute(inner);
+        inner = context->EvalFastRotationExt(inner, giantStep.rotation, innerPrecompute, false);
+    }
+
+    sum.add(inner, first);
+}
 
 
 std::vector<double> rotate_plain(const std::vector<double>& vector, int index) {
@@ -20,157 +157,525 @@ std::vector<double> rotate_plain(const std::vector<double>& vector, int index) {
 }
 
 
+/***
+ * Builds a schedule out of the non-zero diagonals of a matrix. The diagonals are rotated by minus their giant step in
+ * place and in parallel, and the giant steps and baby steps that are referenced by them are recorded.
+ */
+static DiagonalSchedule index_diagonals(std::map<unsigned int, std::vector<double>> diagonals, uint32_t batchSize,
+                                        uint32_t outputSize, std::vector<unsigned int> reductions) {
+    DiagonalSchedule schedule;
+    schedule.batchSize = batchSize;
+    schedule.outputSize = outputSize;
+    schedule.n1 = find_n1(batchSize);
+    schedule.reductions = std::move(reductions);
+
+    std::set<unsigned int> babySteps;
+
+    for (auto& diagonal : diagonals) {
+        unsigned int giantStep = (diagonal.first / schedule.n1) * schedule.n1;
+        unsigned int babyStep = diagonal.first % schedule.n1;
+
+        if (schedule.giantSteps.empty() || schedule.giantSteps.back().rotation != giantStep)
+            schedule.giantSteps.push_back({giantStep, {}});
+
+        schedule.giantSteps.back().terms.push_back({babyStep, schedule.diagonals.size()});
+
+        if (babyStep != 0)
+            babySteps.insert(babyStep);
+
+        schedule.offsets.push_back(diagonal.first);
+        schedule.diagonals.push_back(std::move(diagonal.second));
+    }
+
+    schedule.babySteps.assign(babySteps.begin(), babySteps.end());
+
+    //  Same as rotate_plain(diagonal, -giantStep), without a copy of the diagonal
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < schedule.diagonals.size(); i++) {
+        unsigned int giantStep = (schedule.offsets[i] / schedule.n1) * schedule.n1;
+        auto& diagonal = schedule.diagonals[i];
+
+        if (giantStep != 0)
+            std::rotate(diagonal.begin(), diagonal.end() - giantStep, diagonal.end());
+    }
+
+    return schedule;
+}
+
+
+size_t schedule_cost(const std::vector<unsigned int>& offsets, uint32_t batchSize, size_t reductions) {
+    unsigned int n1 = find_n1(batchSize);
+
+    std::set<unsigned int> babySteps;
+    std::set<unsigned int> giantSteps;
+
+    for (unsigned int offset : offsets) {
+        if (offset % n1 != 0)
+            babySteps.insert(offset % n1);
+        if (offset / n1 != 0)
+            giantSteps.insert(offset / n1);
+    }
+
+    return 10 * (babySteps.size() + giantSteps.size() + reductions) + offsets.size();
+}
+
+
+DiagonalSchedule make_diagonal_schedule(const Tensor& matrix, uint32_t batchSize) {
+    uint32_t inputSize = matrix.rows();
+    uint32_t outputSize = matrix.cols();
+
+    if (inputSize > batchSize || outputSize > batchSize) {
+        std::cerr << "Matrix of shape " << inputSize << "x" << outputSize << " does not fit into the batch size "
+                  << batchSize << "." << std::endl;
+        exit(1);
+    }
+
+    //  The hybrid method only pays off if the output dimension is padded to fewer slots than the input dimension
+    if (next_power2(outputSize) < next_power2(inputSize)) {
+        std::vector<unsigned int> reductions;
+        for (unsigned int step = next_power2(inputSize) / 2; step >= next_power2(outputSize); step /= 2)
+            reductions.push_back(step);
+
+        size_t hybridCost = schedule_cost(hybrid_offsets(matrix, batchSize), batchSize, reductions.size());
+        size_t bandedCost = schedule_cost(banded_offsets(matrix, batchSize), batchSize, 0);
+
+        if (hybridCost < bandedCost)
+            return index_diagonals(hybrid_diagonals(matrix, batchSize), batchSize, outputSize, reductions);
+    }
+
+    return index_diagonals(banded_diagonals(matrix, batchSize), batchSize, outputSize, {});
+}
+
+
+std::vector<int> schedule_rotations(const DiagonalSchedule& schedule) {
+    std::set<int> rotations(schedule.babySteps.begin(), schedule.babySteps.end());
+
+    for (const auto& giantStep : schedule.giantSteps)
+        if (giantStep.rotation != 0)
+            rotations.insert(giantStep.rotation);
+
+    rotations.insert(schedule.reductions.begin(), schedule.reductions.end());
+
+    return std::vector<int>(rotations.begin(), rotations.end());
+}
+
+
+std::map<unsigned int, std::vector<double>> schedule_diagonals(const DiagonalSchedule& schedule) {
+    if (!schedule.reductions.empty()) {
+        std::cerr << "Diagonals of a schedule with a hybrid reduction cannot be used on their own." << std::endl;
+        exit(1);
+    }
+
+    std::map<unsigned int, std::vector<double>> diagonals;
+
+    for (size_t i = 0; i < schedule.offsets.size(); i++) {
+        unsigned int giantStep = (schedule.offsets[i] / schedule.n1) * schedule.n1;
+
+        //  Undoes the rotation by minus the giant step of index_diagonals
+        auto& diagonal = diagonals[schedule.offsets[i]];
+        diagonal = schedule.diagonals[i];
+        std::rotate(diagonal.begin(), diagonal.begin() + giantStep, diagonal.end());
+    }
+
+    return diagonals;
+}
+
+
+std::map<unsigned int, std::vector<double>> compose_diagonals(const std::map<unsigned int, std::vector<double>>& first,
+                                                              const std::map<unsigned int, std::vector<double>>& second,
+                                                              uint32_t batchSize) {
+    std::map<unsigned int, std::vector<double>> result;
+
+    for (const auto& b : second) {
+        for (const auto& a : first) {
+            auto& diagonal = result[(b.first + a.first) % batchSize];
+            if (diagonal.empty())
+                diagonal.resize(batchSize, .0);
+
+            for (uint32_t r = 0; r < batchSize; r++)
+                diagonal[r] += b.second[r] * a.second[(r + b.first) % batchSize];
+        }
+    }
+
+    //  Products of non-zero diagonals may cancel out
+    for (auto it = result.begin(); it != result.end();) {
+        if (std::all_of(it->second.begin(), it->second.end(), [](double v) { return v == .0; }))
+            it = result.erase(it);
+        else
+            it++;
+    }
+
+    return result;
+}
+
+
+std::vector<double> apply_diagonals(const std::map<unsigned int, std::vector<double>>& diagonals,
+                                    const std::vector<double>& vector, uint32_t batchSize) {
+    std::vector<double> result(batchSize, .0);
+
+    for (const auto& diagonal : diagonals)
+        for (uint32_t r = 0; r < batchSize; r++) {
+            uint32_t in = (r + diagonal.first) % batchSize;
+
+            if (in < vector.size())
+                result[r] += diagonal.second[r] * vector[in];
+        }
+
+    return result;
+}
+
+
+DiagonalSchedule make_diagonal_schedule(std::map<unsigned int, std::vector<double>> diagonals, uint32_t batchSize,
+                                        uint32_t outputSize) {
+    return index_diagonals(std::move(diagonals), batchSize, outputSize, {});
+}
+
+
 Ciphertext<DCRTPoly> matrix_multiplication(
-        const std::vector<std::vector<double>>& matrix,
+        const Tensor& matrix,
         const Ciphertext<DCRTPoly>& vector,
         CryptoContext<DCRTPoly> context,
         bool parallel
 ) {
-    Ciphertext<DCRTPoly> result = parallel ?
-           matrix_multiplication_parallel(transpose(matrix), vector, context):
-           matrix_multiplication_sequential(transpose(matrix), vector, context);
+    uint32_t batchSize = vector->GetEncodingParameters()->GetBatchSize();
 
-    //  The following Code is for tracking the size of a ciphertext
-    uint32_t output_size = matrix[0].size();
+    return matrix_multiplication(make_diagonal_schedule(matrix, batchSize), vector, context, parallel);
+}
 
-    auto size = std::make_shared<MetadataTest>();
-    size->SetMetadata(std::to_string(output_size));
 
-    MetadataTest::StoreMetadata<DCRTPoly>(result, size);
+Ciphertext<DCRTPoly> matrix_multiplication(
+        const DiagonalSchedule& schedule,
+        const Ciphertext<DCRTPoly>& vector,
+        CryptoContext<DCRTPoly> context,
+        bool parallel,
+        PlaintextCache* cache,
+        MatMulEngine engine
+) {
+    if (engine == MatMulEngine::DEFAULT)
+        engine = defaultEngine;
+
+    Tracer::Span span("linear", "matrix multiplication");
+
+    Ciphertext<DCRTPoly> result;
+    if (engine == MatMulEngine::DOUBLE_HOISTED)
+        result = matrix_multiplication_double_hoisted(schedule, vector, context, parallel, cache);
+    else
+        result = parallel ?
+           matrix_multiplication_parallel(schedule, vector, context, cache):
+           matrix_multiplication_sequential(schedule, vector, context, cache);
+
+    //  A matrix without any non-zero diagonal still has to return a valid ciphertext on the same level as the others
+    if (!result) {
+        result = context->EvalMult(vector, .0);
+        Profiler::count(&LayerProfile::scalarMults);
+    }
+
+    //  Operations are counted here on the calling thread, as the engines issue them from OpenMP threads
+    if (Profiler::isEnabled()) {
+        uint64_t products = 0;
+        uint64_t giantRotations = 0;
+        for (const auto& giantStep : schedule.giantSteps) {
+            products += giantStep.terms.size();
+            giantRotations += giantStep.rotation != 0;
+        }
+
+        //  The double hoisted engine rotates the giant steps by hoisted key switches as well
+        bool doubleHoisted = engine == MatMulEngine::DOUBLE_HOISTED;
+        uint64_t fast = schedule.babySteps.size() + (doubleHoisted ? giantRotations : 0);
+        uint64_t regular = (doubleHoisted ? 0 : giantRotations) + schedule.reductions.size();
+
+        Profiler::count(&LayerProfile::fastRotations, fast);
+        Profiler::count(&LayerProfile::rotations, regular);
+        Profiler::count(&LayerProfile::keySwitches, fast + regular);
+        Profiler::count(&LayerProfile::plainMults, products);
+    }
+
+    store_output_size(result, schedule.outputSize);
 
     return result;
 }
 
 
-Ciphertext<DCRTPoly> matrix_multiplication_sequential (const std::vector<std::vector<double>>& matrix, const Ciphertext<DCRTPoly>& vector, CryptoContext<DCRTPoly> context) {
-    uint32_t batchSize = vector->GetEncodingParameters()->GetBatchSize();
+Ciphertext<DCRTPoly> matrix_multiplication_sequential (const DiagonalSchedule& schedule, const Ciphertext<DCRTPoly>& vector, CryptoContext<DCRTPoly> context, PlaintextCache* cache) {
+    //  Doing rotations precompute in order to optimize rotations of the ciphertext
+    auto cipherPrecompute = context->EvalFastRotationPrecompute(vector);
+    uint32_t M = 2 * context->GetRingDimension();
 
-    //  Resizing matrix to the contexts batchSize and getting a matrix in diagonal order
-    auto diagonals = diagonal_transformation(
-            resizeMatrix(matrix, batchSize, batchSize)
-            );
+    //  Caching the rotations of the vector variable needed later. Only baby steps that are referenced by a non-zero
+    //  diagonal are computed, the zeroth baby step is the vector itself
+    std::vector<Ciphertext<DCRTPoly>> rotCache(schedule.n1);
+    rotCache[0] = vector;
+    for (unsigned int j : schedule.babySteps) {
+        Tracer::Span span("bsgs", "baby step", j);
+        rotCache[j] = context->EvalFastRotation(vector, j, M, cipherPrecompute);
+    }
 
+    //  Giant steps without any non-zero diagonal do not appear in the schedule, therefore the result is only
+    //  initialized by the first term that actually contributes
+    Ciphertext<DCRTPoly> result;
+    for (const auto& giantStep : schedule.giantSteps) {
+        Tracer::Span span("bsgs", "giant step", giantStep.rotation);
+        Ciphertext<DCRTPoly> subResult;
+
+        for (const auto& term : giantStep.terms) {
+            size_t d = term.second;
+            Plaintext pl = encode_diagonal(schedule.offsets[d], schedule.diagonals[d], vector, context, cache);
+            Ciphertext<DCRTPoly> product = context->EvalMult(pl, rotCache[term.first]);
+
+            if (subResult)
+                subResult += product;
+            else
+                subResult = product;
+        }
 
-    //  Finding the optimal configuration for n1 and n2 where batchSize = n1 * n2
-    unsigned int n1 = find_n1(batchSize);
-    unsigned int n2 = batchSize / n1;
+        if (giantStep.rotation != 0)
+            subResult = context->EvalRotate(subResult, giantStep.rotation);
+
+        if (result)
+            result += subResult;
+        else
+            result = subResult;
+    }
+
+    //  Rotate-and-sum of the hybrid method
+    if (result) {
+        Tracer::Span span("bsgs", "reductions");
+        for (unsigned int step : schedule.reductions)
+            result += context->EvalRotate(result, step);
+    }
+
+    return result;
+}
 
-    //  Calculating first term in the sum in order to avoid passing the private key to encrypt 0 and then later adding
-    //  to that via a for loop. Because of that for loops later will start at 1
-    Plaintext pl = context->MakeCKKSPackedPlaintext(diagonals[0]);
-    Ciphertext<DCRTPoly> subResult = context->EvalMult(pl, vector);
 
+Ciphertext<DCRTPoly> matrix_multiplication_parallel(const DiagonalSchedule& schedule, const Ciphertext<DCRTPoly>& vector, CryptoContext<DCRTPoly> context, PlaintextCache* cache) {
     //  Doing rotations precompute in order to optimize rotations of the ciphertext
     auto cipherPrecompute = context->EvalFastRotationPrecompute(vector);
     uint32_t M = 2 * context->GetRingDimension();
 
-    //  Calculating first sub-sum and caching all rotations of the vector variable needed later
-    std::vector<Ciphertext<DCRTPoly>> rotCache;
-    for (unsigned int j=1; j<n1; j++) {
-        Ciphertext<DCRTPoly> rotation = context->EvalFastRotation(vector, j, M, cipherPrecompute);
-        rotCache.push_back(rotation);
+    //  Caching the rotations of the vector variable needed later. Only baby steps that are referenced by a non-zero
+    //  diagonal are computed. Every thread writes to its own index, so the cache is allocated beforehand
+    std::vector<Ciphertext<DCRTPoly>> rotCache(schedule.n1);
+    rotCache[0] = vector;
 
-        if (!std::all_of(diagonals[j].begin(), diagonals[j].end(), [](double x) {return x==.0;})) {
-            pl = context->MakeCKKSPackedPlaintext(diagonals[j]);
-            subResult += context->EvalMult(pl, rotation);
-        }
+    //  Adding parallelization in the form of an OpenMP for loop
+    #pragma omp parallel for
+    for (size_t i=0; i<schedule.babySteps.size(); i++) {
+        unsigned int j = schedule.babySteps[i];
+        Tracer::Span span("bsgs", "baby step", j);
+        rotCache[j] = context->EvalFastRotation(vector, j, M, cipherPrecompute);
     }
 
-    Ciphertext<DCRTPoly> result = subResult;
+    //  Every thread accumulates the giant steps it works on in its own partial result, so that no thread has to wait
+    //  for another one while adding. Since the number of non-zero diagonals differs between giant steps, they are
+    //  handed out dynamically
+    #ifdef _OPENMP
+    std::vector<Ciphertext<DCRTPoly>> partials(omp_get_max_threads());
+    #else
+    std::vector<Ciphertext<DCRTPoly>> partials(1);
+    #endif
+
+    #pragma omp parallel
+    {
+        #ifdef _OPENMP
+        Ciphertext<DCRTPoly>& partial = partials[omp_get_thread_num()];
+        #else
+        Ciphertext<DCRTPoly>& partial = partials[0];
+        #endif
+
+        #pragma omp for schedule(dynamic)
+        for (size_t i = 0; i < schedule.giantSteps.size(); i++) {
+            const GiantStep& giantStep = schedule.giantSteps[i];
+            Tracer::Span span("bsgs", "giant step", giantStep.rotation);
+            Ciphertext<DCRTPoly> subCipher;
+
+            for (const auto& term : giantStep.terms) {
+                size_t d = term.second;
+                Plaintext subPlain = encode_diagonal(schedule.offsets[d], schedule.diagonals[d], vector, context, cache);
+                Ciphertext<DCRTPoly> product = context->EvalMult(subPlain, rotCache[term.first]);
+
+                if (subCipher)
+                    subCipher += product;
+                else
+                    subCipher = product;
+            }
 
-    //  Calculating the remaining terms in the sums
-    for (unsigned int k=1; k<n2; k++) {
-        pl = context->MakeCKKSPackedPlaintext(rotate_plain(diagonals[k*n1], -k*n1));
-        subResult = context->EvalMult(pl, vector);
+            if (giantStep.rotation != 0)
+                subCipher = context->EvalRotate(subCipher, giantStep.rotation);
 
-        for (unsigned int j=1; j<n1; j++) {
-            if (!std::all_of(diagonals[k*n1 + j].begin(), diagonals[k*n1 + j].end(), [](double x) {return x == .0;})) {
-                pl = context->MakeCKKSPackedPlaintext(rotate_plain(diagonals[k * n1 + j], -k * n1));
-                subResult += context->EvalMult(pl, rotCache[j - 1]);
-            }
+            if (partial)
+                partial += subCipher;
+            else
+                partial = subCipher;
         }
+    }
+
+    Ciphertext<DCRTPoly> result = tree_addition(std::move(partials), context);
 
-        result += context->EvalRotate(subResult, k*n1);
+    //  Rotate-and-sum of the hybrid method
+    if (result) {
+        Tracer::Span span("bsgs", "reductions");
+        for (unsigned int step : schedule.reductions)
+            result += context->EvalRotate(result, step);
     }
 
     return result;
 }
 
 
-Ciphertext<DCRTPoly> matrix_multiplication_parallel(const std::vector<std::vector<double>>& matrix, const Ciphertext<DCRTPoly>& vector, CryptoContext<DCRTPoly> context) {
-    uint32_t batchSize = vector->GetEncodingParameters()->GetBatchSize();
+Ciphertext<DCRTPoly> matrix_multiplication_double_hoisted(const DiagonalSchedule& schedule, const Ciphertext<DCRTPoly>& vector, CryptoContext<DCRTPoly> context, bool parallel, PlaintextCache* cache) {
+    auto cryptoParams = std::dynamic_pointer_cast<CryptoParametersCKKSRNS>(context->GetCryptoParameters());
+    if (cryptoParams->GetKeySwitchTechnique() != HYBRID) {
+        std::cerr << "The double hoisted matrix multiplication requires hybrid key switching." << std::endl;
+        exit(1);
+    }
 
-    //  Resizing matrix to the contexts batchSize and getting a matrix in diagonal order
-    auto diagonals = diagonal_transformation(
-            resizeMatrix(matrix, batchSize, batchSize)
-    );
+    if (schedule.giantSteps.empty())
+        return nullptr;
 
+    //  The products are computed by hand, so the rescaling that EvalMult does automatically has to be done here
+    Ciphertext<DCRTPoly> x = vector;
+    if (x->GetNoiseScaleDeg() > 1 && cryptoParams->GetScalingTechnique() != FIXEDMANUAL) {
+        x = vector->Clone();
+        context->GetScheme()->ModReduceInternalInPlace(x, BASE_NUM_LEVELS_TO_DROP);
+    }
 
-    //  Finding the optimal configuration for n1 and n2 where batchSize = n1 * n2
-    unsigned int n1 = find_n1(batchSize);
-    unsigned int n2 = batchSize / n1;
+    //  Baby steps are rotated into the extended basis. The zeroth baby step only needs the extension itself
+    auto cipherPrecompute = context->EvalFastRotationPrecompute(x);
 
-    //  Calculating first term in the sum in order to avoid passing the private key to encrypt 0 and then later adding
-    //  to that via a for loop. Because of that for loops later will start at 1
-    Plaintext pl = context->MakeCKKSPackedPlaintext(diagonals[0]);
-    Ciphertext<DCRTPoly> subResult = context->EvalMult(pl, vector);
+    std::vector<Ciphertext<DCRTPoly>> rotCache(schedule.n1);
+    rotCache[0] = context->KeySwitchExt(x, true);
 
-    //  Doing rotations precompute in order to optimize rotations of the ciphertext
-    auto cipherPrecompute = context->EvalFastRotationPrecompute(vector);
-    uint32_t M = 2 * context->GetRingDimension();
+    #pragma omp parallel for if(parallel)
+    for (size_t i=0; i<schedule.babySteps.size(); i++) {
+        unsigned int j = schedule.babySteps[i];
+        Tracer::Span span("bsgs", "baby step", j);
+        rotCache[j] = context->EvalFastRotationExt(x, j, cipherPrecompute, true);
+    }
 
-    //  Calculating first sub-sum and caching all rotations of the vector variable needed later. In the sequential
-    //  version the data is written by a push_back operation, this can not be done in parallel, since the order of the
-    //  vector would then be false, depending on what thread finishes first
-    std::vector<Ciphertext<DCRTPoly>> rotCache(n1 - 1);
+    //  Every thread sums up its giant steps on its own, as in matrix_multiplication_parallel
+    #ifdef _OPENMP
+    std::vector<ExtendedSum> partials(parallel ? omp_get_max_threads() : 1);
+    #else
+    std::vector<ExtendedSum> partials(1);
+    #endif
+
+    #pragma omp parallel if(parallel)
+    {
+        #ifdef _OPENMP
+        ExtendedSum& partial = partials[omp_get_thread_num()];
+        #else
+        ExtendedSum& partial = partials[0];
+        #endif
+
+        #pragma omp for schedule(dynamic)
+        for (size_t i = 0; i < schedule.giantSteps.size(); i++)
+            double_hoisted_giant_step(schedule, schedule.giantSteps[i], rotCache, x, context, cache, partial);
+    }
 
-    //  Adding parallelization in the form of an OpenMP for loop
-    #pragma omp parallel for
-    for (unsigned int j=1; j<n1; j++) {
-        //  Adding to variables that are used by each thread in order to store separate sub results
-        Plaintext subPlain;
-        Ciphertext<DCRTPoly> subCipher;
+    ExtendedSum sum;
+    for (const auto& partial : partials)
+        if (partial.extended)
+            sum.add(partial.extended, partial.first);
 
-        Ciphertext<DCRTPoly> rotation = context->EvalFastRotation(vector, j, M, cipherPrecompute);
+    //  The single mod-down of the whole matrix multiplication
+    Ciphertext<DCRTPoly> result = context->KeySwitchDown(sum.extended);
+    result->GetElements()[0] += sum.first;
 
-        if (!std::all_of(diagonals[j].begin(), diagonals[j].end(), [](double x) {return x==.0;})) {
-            subPlain = context->MakeCKKSPackedPlaintext(diagonals[j]);
+    //  Rotate-and-sum of the hybrid method
+    Tracer::Span reductions("bsgs", "reductions");
+    for (unsigned int step : schedule.reductions)
+        result += context->EvalRotate(result, step);
+
+    return result;
+}
+
+
+void set_default_engine(MatMulEngine engine) {
+    defaultEngine = engine == MatMulEngine::DEFAULT ? MatMulEngine::HOISTED : engine;
+}
+
+
+MatMulEngine get_default_engine() {
+    return defaultEngine;
+}
 
-            //  The subResult variable should only be written to by one thread at a time
-            #pragma omp critical
-            subResult += context->EvalMult(subPlain, rotation);
-        }
 
-        //  Same goes for the rotation cache
-        #pragma omp critical
-        rotCache[j-1] = rotation;
+Ciphertext<DCRTPoly> rotate_and_sum(const Ciphertext<DCRTPoly>& x, uint32_t count, uint32_t step,
+                                    CryptoContext<DCRTPoly> context) {
+    uint32_t batchSize = x->GetEncodingParameters()->GetBatchSize();
+    Ciphertext<DCRTPoly> result = x;
+    uint32_t length = 1;
+    uint64_t rotations = 0;
+
+    //  Going through the bits of count from the highest one, the number of summed copies is doubled for every bit and
+    //  increased by one if the bit is set
+    int highestBit = 31 - __builtin_clz(std::max(count, 1u));
+    for (int bit = highestBit - 1; bit >= 0; bit--) {
+        result = context->EvalAdd(result, context->EvalRotate(result, (length * step) % batchSize));
+        length *= 2;
+        rotations++;
+
+        if ((count >> bit) & 1) {
+            result = context->EvalAdd(result, context->EvalRotate(x, (length * step) % batchSize));
+            length++;
+            rotations++;
+        }
     }
 
-    Ciphertext<DCRTPoly> result = subResult;
+    Profiler::count(&LayerProfile::rotations, rotations);
+    Profiler::count(&LayerProfile::keySwitches, rotations);
 
-    //  Calculating the remaining terms in the sums
-    #pragma omp parallel for
-    for (unsigned int k = 1; k < n2; k++) {
-        Ciphertext<DCRTPoly> subCipher;
-        Plaintext subPlain;
-        subPlain = context->MakeCKKSPackedPlaintext(rotate_plain(diagonals[k * n1], -k * n1));
-        subCipher = context->EvalMult(subPlain, vector);
-
-        for (unsigned int j = 1; j < n1; j++) {
-            if (!std::all_of(diagonals[k * n1 + j].begin(), diagonals[k * n1 + j].end(),
-                             [](double x) { return x == .0; })) {
-                subPlain = context->MakeCKKSPackedPlaintext(rotate_plain(diagonals[k * n1 + j], -k * n1));
-                subCipher += context->EvalMult(subPlain, rotCache[j - 1]);
-            }
+    return result;
+}
+
+
+std::vector<int> rotate_and_sum_rotations(uint32_t count, uint32_t step, uint32_t batchSize) {
+    std::set<int> rotations;
+    uint32_t length = 1;
+
+    int highestBit = 31 - __builtin_clz(std::max(count, 1u));
+    for (int bit = highestBit - 1; bit >= 0; bit--) {
+        rotations.insert((length * step) % batchSize);
+        length *= 2;
+
+        if ((count >> bit) & 1) {
+            rotations.insert((length * step) % batchSize);
+            length++;
         }
+    }
+
+    rotations.erase(0);
 
-        subCipher = context->EvalRotate(subCipher, k * n1);
+    return std::vector<int>(rotations.begin(), rotations.end());
+}
+
+
+void store_output_size(const Ciphertext<DCRTPoly>& x, uint32_t size) {
+    //  The following Code is for tracking the size of a ciphertext
+    auto metadata = std::make_shared<MetadataTest>();
+    metadata->SetMetadata(std::to_string(size));
+
+    MetadataTest::StoreMetadata<DCRTPoly>(x, metadata);
+}
 
-        #pragma omp critical
-        result += subCipher;
+
+Ciphertext<DCRTPoly> tree_addition(std::vector<Ciphertext<DCRTPoly>> terms, CryptoContext<DCRTPoly> context) {
+    Tracer::Span span("bsgs", "tree addition");
+
+    terms.erase(std::remove(terms.begin(), terms.end(), nullptr), terms.end());
+
+    if (terms.empty())
+        return nullptr;
+
+    //  In every level of the tree, term i absorbs term i + stride
+    for (size_t stride = 1; stride < terms.size(); stride *= 2) {
+        #pragma omp parallel for
+        for (size_t i = 0; i < terms.size() - stride; i += 2 * stride)
+            terms[i] = context->EvalAdd(terms[i], terms[i + stride]);
     }
 
-    return result;
+    return terms[0];
 }
 
 
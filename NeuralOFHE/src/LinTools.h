@@ -13,15 +13,200 @@
 #define TEST_MNIST_LINTOOLS_H
 
 #include <vector>
+#include <map>
+#include <set>
 #include <future>
 
 #include "MatrixFormatting.h"
+#include "PlaintextCache.h"
 #include "UnitTestMetadataTestSer.h"
 #include "openfhe.h"
 
 using namespace lbcrypto;
 
 
+/***
+ * Non-zero part of one giant step of a baby-step giant-step matrix multiplication.
+ */
+struct GiantStep {
+    /***
+     * Rotation that is applied to the sum of the giant step, i.e. k * n1.
+     */
+    unsigned int rotation;
+
+    /***
+     * Pairs of baby step j and the position of the diagonal with offset k * n1 + j within DiagonalSchedule::diagonals.
+     */
+    std::vector<std::pair<unsigned int, size_t>> terms;
+};
+
+
+/***
+ * Plaintext side of a baby-step giant-step matrix multiplication. It only depends on the matrix and the batch size of
+ * the context, so it is built once per linear operator and reused for every ciphertext that passes through it.
+ *
+ * Every diagonal is identified by its rotation offset t in [0, batchSize), which is split into the giant step
+ * (t / n1) * n1 and the baby step t % n1. Only non-zero diagonals are stored and the schedule records which giant steps
+ * and baby steps they actually reference, so that no rotation is computed that is not needed.
+ */
+struct DiagonalSchedule {
+    /***
+     * Batch size the diagonals were built for and the number of baby steps n1. n1 is the same for all matrices of a
+     * batch size, so that the rotation keys of GetRotations cover every schedule.
+     */
+    uint32_t batchSize;
+    unsigned int n1;
+
+    /***
+     * Number of meaningful slots of the result, which is stored as metadata on the output ciphertext.
+     */
+    uint32_t outputSize;
+
+    /***
+     * Offsets of the non-zero diagonals in ascending order and the diagonals themselves. Every diagonal is already
+     * rotated by minus its giant step, so that it can be multiplied with its baby step directly.
+     */
+    std::vector<unsigned int> offsets;
+    std::vector<std::vector<double>> diagonals;
+
+    /***
+     * Non-zero baby steps j > 0 referenced by any giant step in ascending order. The zeroth baby step is the input
+     * itself.
+     */
+    std::vector<unsigned int> babySteps;
+
+    /***
+     * Giant steps that contain at least one non-zero diagonal.
+     */
+    std::vector<GiantStep> giantSteps;
+
+    /***
+     * Rotations of the rotate-and-sum reduction that follows the diagonal sum. Empty unless the hybrid method for wide
+     * matrices is used.
+     */
+    std::vector<unsigned int> reductions;
+};
+
+
+/***
+ * Engines that carry out the homomorphic part of a matrix multiplication.
+ *
+ * HOISTED: The baby steps are hoisted rotations of the input and every giant step is a full rotation with its own key
+ * switch and mod-down.
+ * DOUBLE_HOISTED: The baby steps are kept in the extended basis QP, so that the plaintext products of a giant step are
+ * summed up before a single mod-down. The giant step rotations are summed in QP as well and only the final result is
+ * brought back to Q. Key switching dominates the runtime of large layers, which is roughly halved by this engine.
+ * Requires hybrid key switching.
+ * DEFAULT: The engine set with set_default_engine, HOISTED unless changed.
+ */
+enum class MatMulEngine {
+    DEFAULT,
+    HOISTED,
+    DOUBLE_HOISTED
+};
+
+
+/***
+ * Function that sets the engine used by every matrix multiplication that asks for MatMulEngine::DEFAULT.
+ *
+ * @param engine Engine that should be used. Passing MatMulEngine::DEFAULT resets it to MatMulEngine::HOISTED
+ */
+void set_default_engine(MatMulEngine engine);
+
+
+/***
+ * Function that returns the engine used by every matrix multiplication that asks for MatMulEngine::DEFAULT, e.g. to
+ * warm up the plaintexts in the basis that engine encodes them in.
+ *
+ * @return HOISTED or DOUBLE_HOISTED
+ */
+MatMulEngine get_default_engine();
+
+
+/***
+ * Function that builds the diagonal schedule of a matrix. The matrix is expected in the same orientation as for
+ * matrix_multiplication, i.e. of shape input size x output size. The schedule works on the actual shape of the matrix:
+ * either only the diagonals of the rectangular matrix are used, or for wide matrices the hybrid method with a final
+ * rotate-and-sum, depending on which needs fewer rotations and multiplications.
+ *
+ * @param matrix Plaintext matrix, which should later be multiplied with ciphertext vectors
+ * @param batchSize Batch size of the context the ciphertexts are encrypted with
+ */
+DiagonalSchedule make_diagonal_schedule(const Tensor& matrix, uint32_t batchSize);
+
+
+/***
+ * Overload of make_diagonal_schedule for operators that compute the diagonals of their linear map directly, without a
+ * dense matrix. Diagonals follow the convention of banded_diagonals: the entry at slot r of the diagonal with offset t
+ * is the factor of the input slot (r + t) mod batchSize for the output slot r.
+ *
+ * @param diagonals Non-zero diagonals of length batchSize, keyed by their offset in [0, batchSize)
+ * @param batchSize Batch size of the context the ciphertexts are encrypted with
+ * @param outputSize Number of meaningful slots of the result
+ */
+DiagonalSchedule make_diagonal_schedule(std::map<unsigned int, std::vector<double>> diagonals, uint32_t batchSize,
+                                        uint32_t outputSize);
+
+
+/***
+ * Function that returns the rotation indices a matrix multiplication with the schedule requests: the referenced baby
+ * steps, the non-zero giant steps and the rotations of the hybrid reduction. Both engines use the same indices.
+ *
+ * @param schedule Diagonal schedule of the plaintext matrix
+ * @return Rotation indices in ascending order
+ */
+std::vector<int> schedule_rotations(const DiagonalSchedule& schedule);
+
+
+/***
+ * Function that estimates the cost of evaluating a schedule with the given diagonal offsets. A rotation needs a key
+ * switch, which is about an order of magnitude more expensive than a plaintext multiplication.
+ *
+ * @param offsets Offsets of the non-zero diagonals
+ * @param batchSize Batch size the diagonals were built for
+ * @param reductions Number of rotations of the hybrid reduction
+ * @return Cost in units of plaintext multiplications
+ */
+size_t schedule_cost(const std::vector<unsigned int>& offsets, uint32_t batchSize, size_t reductions = 0);
+
+
+/***
+ * Function that returns the diagonals of a schedule in the convention of make_diagonal_schedule, i.e. without the
+ * rotation by their giant step. Schedules of the hybrid method have no such representation, as their diagonals only
+ * make sense together with the reduction.
+ *
+ * @param schedule Diagonal schedule without reductions
+ * @return Non-zero diagonals keyed by their offset
+ */
+std::map<unsigned int, std::vector<double>> schedule_diagonals(const DiagonalSchedule& schedule);
+
+
+/***
+ * Function that composes two linear maps given by their diagonals, i.e. returns the diagonals of the map that applies
+ * first and then second. Diagonal s + t receives second[s][r] * first[t][r + s] at slot r.
+ *
+ * @param first Diagonals of the map that is applied first
+ * @param second Diagonals of the map that is applied second
+ * @param batchSize Batch size the diagonals were built for
+ * @return Non-zero diagonals of the composition
+ */
+std::map<unsigned int, std::vector<double>> compose_diagonals(const std::map<unsigned int, std::vector<double>>& first,
+                                                              const std::map<unsigned int, std::vector<double>>& second,
+                                                              uint32_t batchSize);
+
+
+/***
+ * Function that applies a linear map given by its diagonals to a plaintext vector.
+ *
+ * @param diagonals Diagonals of the map
+ * @param vector Vector of at most batchSize entries, missing entries are zero
+ * @param batchSize Batch size the diagonals were built for
+ * @return Result of length batchSize
+ */
+std::vector<double> apply_diagonals(const std::map<unsigned int, std::vector<double>>& diagonals,
+                                    const std::vector<double>& vector, uint32_t batchSize);
+
+
 /***
  * Function that does plaintext matrix with ciphertext vector multiplication with the option to turn off parallel
  * computing. Default is with parallel computing
@@ -32,44 +217,136 @@ using namespace lbcrypto;
  * @param parallel Boolean that toggles parallel computing
  */
 Ciphertext<DCRTPoly> matrix_multiplication(
-        const std::vector<std::vector<double>>& matrix,
+        const Tensor& matrix,
         const Ciphertext<DCRTPoly>& vector,
         CryptoContext<DCRTPoly> context,
         bool parallel = true
         );
 
 
+/***
+ * Overload of matrix_multiplication that uses an already built diagonal schedule, so that only homomorphic operations
+ * are left to be done. If a plaintext cache is given, the encoded diagonals are taken from it.
+ *
+ * @param schedule Diagonal schedule of the plaintext matrix
+ * @param vector Ciphertext vector which should be multiplied
+ * @param context Cryptocontext belonging to the ciphertext
+ * @param parallel Boolean that toggles parallel computing
+ * @param cache Cache of encoded diagonals, which are keyed by their index in the schedule. May be a nullptr
+ * @param engine Engine that carries out the homomorphic operations
+ */
+Ciphertext<DCRTPoly> matrix_multiplication(
+        const DiagonalSchedule& schedule,
+        const Ciphertext<DCRTPoly>& vector,
+        CryptoContext<DCRTPoly> context,
+        bool parallel = true,
+        PlaintextCache* cache = nullptr,
+        MatMulEngine engine = MatMulEngine::DEFAULT
+        );
+
+
 /***
  * Function that carries out a matrix multiplication between a plain matrix and an encrypted CKKS vector using the
- * baby-step giant-step diagonal method. The matrix will be resized to be a quadratic matrix according to the contexts
- * batch size.
+ * baby-step giant-step diagonal method. Only the giant steps with non-zero diagonals are evaluated and the diagonals
+ * are encoded at the level of the ciphertext.
  *
- * @param matrix Plaintext matrix, which should be multiplied with the vector
+ * @param schedule Diagonal schedule of the plaintext matrix
  * @param vector Ciphertext vector which should be multiplied
  * @param context Cryptocontext belonging to the ciphertext
+ * @param cache Cache of encoded diagonals. May be a nullptr
  */
 Ciphertext<DCRTPoly> matrix_multiplication_sequential(
-        const std::vector<std::vector<double>>& matrix,
+        const DiagonalSchedule& schedule,
         const Ciphertext<DCRTPoly>& vector,
-        CryptoContext<DCRTPoly> context
+        CryptoContext<DCRTPoly> context,
+        PlaintextCache* cache = nullptr
         );
 
 
 /***
- * Function that works with the same principle as matrix_multiplication_diagonals but implements parallel computing
- *
+ * Function that works with the same principle as matrix_multiplication_sequential but implements parallel computing.
+ * Giant steps are distributed dynamically among the threads, every thread sums up its giant steps in its own
+ * accumulator and the accumulators are combined by tree_addition.
  *
- * @param matrix Plaintext matrix, which should be multiplied with the vector
+ * @param schedule Diagonal schedule of the plaintext matrix
  * @param vector Ciphertext vector which should be multiplied
  * @param context Cryptocontext belonging to the ciphertext
+ * @param cache Cache of encoded diagonals. May be a nullptr
  */
 Ciphertext<DCRTPoly> matrix_multiplication_parallel(
-        const std::vector<std::vector<double>>& matrix,
+        const DiagonalSchedule& schedule,
+        const Ciphertext<DCRTPoly>& vector,
+        CryptoContext<DCRTPoly> context,
+        PlaintextCache* cache = nullptr
+        );
+
+
+/***
+ * Function that carries out the matrix multiplication with double hoisting, following the linear transforms of the
+ * OpenFHE CKKS bootstrapping. The baby steps are rotated into the extended basis QP, the diagonals are encoded in QP
+ * as well and every giant step needs a single mod-down before its rotation, which again stays in QP. Only the sum of
+ * all giant steps is brought back to Q. A ciphertext that still has to be rescaled is rescaled first.
+ *
+ * @param schedule Diagonal schedule of the plaintext matrix
+ * @param vector Ciphertext vector which should be multiplied
+ * @param context Cryptocontext belonging to the ciphertext, has to use hybrid key switching
+ * @param parallel Boolean that toggles parallel computing
+ * @param cache Cache of encoded diagonals. May be a nullptr
+ */
+Ciphertext<DCRTPoly> matrix_multiplication_double_hoisted(
+        const DiagonalSchedule& schedule,
         const Ciphertext<DCRTPoly>& vector,
-        CryptoContext<DCRTPoly> context
+        CryptoContext<DCRTPoly> context,
+        bool parallel = true,
+        PlaintextCache* cache = nullptr
         );
 
 
+/***
+ * Function that sums up count copies of a ciphertext, where copy i is rotated by i * step. The sum is built by doubling,
+ * so that at most 2 log2(count) rotations are needed.
+ *
+ * @param x Ciphertext that should be summed up
+ * @param count Number of rotated copies
+ * @param step Rotation between two consecutive copies
+ * @param context Cryptocontext belonging to the ciphertext
+ * @return Sum of the rotated copies
+ */
+Ciphertext<DCRTPoly> rotate_and_sum(const Ciphertext<DCRTPoly>& x, uint32_t count, uint32_t step,
+                                    CryptoContext<DCRTPoly> context);
+
+
+/***
+ * Function that returns the rotation indices rotate_and_sum requests.
+ *
+ * @param count Number of rotated copies
+ * @param step Rotation between two consecutive copies
+ * @param batchSize Batch size of the context, to which the indices are normalized
+ * @return Rotation indices
+ */
+std::vector<int> rotate_and_sum_rotations(uint32_t count, uint32_t step, uint32_t batchSize);
+
+
+/***
+ * Function that stores the number of meaningful slots of a ciphertext as its metadata, which is used when decrypting.
+ *
+ * @param x Ciphertext the size belongs to
+ * @param size Number of meaningful slots
+ */
+void store_output_size(const Ciphertext<DCRTPoly>& x, uint32_t size);
+
+
+/***
+ * Function that sums up ciphertexts pairwise in a tree of logarithmic depth, where the additions of each tree level are
+ * carried out in parallel. Entries that are nullptr are ignored.
+ *
+ * @param terms Ciphertexts that should be summed up
+ * @param context Cryptocontext belonging to the ciphertexts
+ * @return Sum of all terms or nullptr if there are none
+ */
+Ciphertext<DCRTPoly> tree_addition(std::vector<Ciphertext<DCRTPoly>> terms, CryptoContext<DCRTPoly> context);
+
+
 /***
  * Function that carries out a plaintext vector-matrix multiplication. Mostly used for accuracy studies of the
  * ciphertext operations.
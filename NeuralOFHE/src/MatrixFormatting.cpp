@@ -1,30 +1,117 @@
 #include "MatrixFormatting.h"
+#include <iostream>
+#include <algorithm>
 
 
-std::vector<std::vector<double>> transpose(std::vector<std::vector<double>> matrix) {
-    std::vector<std::vector<double>> result;
+/***
+ * Edge length of the square tiles in which matrices are traversed. A tile of doubles occupies 32 KiB, so the rows it
+ * reads and the segments it writes stay in cache together.
+ */
+static constexpr size_t TILE = 64;
 
-    for(unsigned int i=0; i<matrix[0].size(); i++) {
-        std::vector<double> row(matrix.size());
-        for (unsigned int j=0; j<matrix.size(); j++) {
-            row[j] = matrix[j][i];
+
+/***
+ * Returns the offsets of all diagonals that receive a non-zero entry, where position(c, r) maps the entry in row c
+ * and column r of the matrix to its diagonal and slot. Tiles are marked in parallel.
+ */
+template <typename Position>
+static std::vector<unsigned int> mark_offsets(const Tensor& matrix, uint32_t batchSize, Position position) {
+    const size_t numRows = matrix.rows();
+    const size_t numCols = matrix.cols();
+
+    std::vector<unsigned char> used(batchSize, 0);
+    unsigned char* mark = used.data();
+
+    #pragma omp parallel for collapse(2) schedule(static) reduction(|:mark[:batchSize])
+    for (size_t c0 = 0; c0 < numRows; c0 += TILE) {
+        for (size_t r0 = 0; r0 < numCols; r0 += TILE) {
+            for (size_t c = c0; c < std::min(c0 + TILE, numRows); c++) {
+                const double* row = matrix.row(c);
+
+                for (size_t r = r0; r < std::min(r0 + TILE, numCols); r++)
+                    if (row[r] != .0)
+                        mark[position(c, r).first] = 1;
+            }
+        }
+    }
+
+    std::vector<unsigned int> offsets;
+    for (unsigned int t = 0; t < batchSize; t++)
+        if (used[t])
+            offsets.push_back(t);
+
+    return offsets;
+}
+
+
+/***
+ * Extracts the non-zero diagonals of a matrix, where position(c, r) maps the entry in row c and column r to its
+ * diagonal and slot. All diagonals are allocated up front and the matrix is walked tile by tile in parallel. Since
+ * position maps different entries to different slots, no two threads ever write the same slot.
+ */
+template <typename Position>
+static std::map<unsigned int, std::vector<double>> extract_diagonals(const Tensor& matrix, uint32_t batchSize,
+                                                                     Position position) {
+    const size_t numRows = matrix.rows();
+    const size_t numCols = matrix.cols();
+
+    std::map<unsigned int, std::vector<double>> result;
+    std::vector<double*> target(batchSize, nullptr);
+
+    for (unsigned int offset : mark_offsets(matrix, batchSize, position)) {
+        auto& diagonal = result[offset];
+        diagonal.assign(batchSize, .0);
+        target[offset] = diagonal.data();
+    }
+
+    #pragma omp parallel for collapse(2) schedule(static)
+    for (size_t c0 = 0; c0 < numRows; c0 += TILE) {
+        for (size_t r0 = 0; r0 < numCols; r0 += TILE) {
+            for (size_t c = c0; c < std::min(c0 + TILE, numRows); c++) {
+                const double* row = matrix.row(c);
+
+                for (size_t r = r0; r < std::min(r0 + TILE, numCols); r++) {
+                    if (row[r] == .0)
+                        continue;
+
+                    auto slot = position(c, r);
+                    target[slot.first][slot.second] = row[r];
+                }
+            }
         }
-        result.push_back(row);
     }
 
     return result;
 }
 
 
-std::vector<double> flattenMatrix(std::vector<std::vector<double>> matrix, bool direction) {
+std::vector<std::vector<double>> transpose(const std::vector<std::vector<double>>& matrix) {
+    const size_t numRows = matrix.size();
+    const size_t numCols = matrix[0].size();
+    std::vector<std::vector<double>> result(numCols, std::vector<double>(numRows));
+
+    //  Rows of the result are written by one thread each. Blocking did not pay off here, as the hardware prefetcher
+    //  already follows the column reads
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < numCols; i++) {
+        double* row = result[i].data();
+
+        for (size_t j = 0; j < numRows; j++)
+            row[j] = matrix[j][i];
+    }
+
+    return result;
+}
+
+
+std::vector<double> flattenMatrix(const std::vector<std::vector<double>>& matrix, bool direction) {
     std::vector<double> result;
 
     if (!direction)
-        matrix = transpose(matrix);
+        return flattenMatrix(transpose(matrix), true);
 
-    for (auto row : matrix)
-        for (auto entry : row)
-            result.push_back(entry);
+    for (const auto& row : matrix)
+        result.insert(result.end(), row.begin(), row.end());
 
     return result;
 }
@@ -35,15 +122,14 @@ unsigned int next_power2 (unsigned int n) {
 }
 
 
-std::vector<std::vector<double>> resizeMatrix(std::vector<std::vector<double>> matrix, size_t numRows, size_t numCols) {
-
-    for (auto &row : matrix)
-        row.resize(numCols, 0);
+std::vector<std::vector<double>> resizeMatrix(const std::vector<std::vector<double>>& matrix, size_t numRows, size_t numCols) {
+    std::vector<std::vector<double>> result(numRows, std::vector<double>(numCols, .0));
 
-    const std::vector<double> zeros(numCols, .0);
-    matrix.resize(numRows, zeros);
+    #pragma omp parallel for schedule(static)
+    for (size_t i=0; i<std::min(numRows, matrix.size()); i++)
+        std::copy_n(matrix[i].begin(), std::min(numCols, matrix[i].size()), result[i].begin());
 
-    return matrix;
+    return result;
 }
 
 unsigned int find_n1(uint32_t batchSize) {
@@ -63,18 +149,182 @@ unsigned int find_n1(uint32_t batchSize) {
 
 
 std::vector<std::vector<double>> diagonal_transformation(const std::vector<std::vector<double>>& matrix) {
-    std::vector<std::vector<double>> result;
+    const size_t numRows = matrix.size();
+    const size_t numCols = matrix[0].size();
+    std::vector<std::vector<double>> result(numRows, std::vector<double>(numCols));
 
-    for (unsigned int i=0; i< matrix.size(); i++) {
-        std::vector<double> row;
-        for (unsigned int j = 0; j < matrix[0].size(); j++) {
-            unsigned int colIndex = (j + i) % matrix[0].size();
-            unsigned int rowIndex = j % matrix.size();
+    //  A tile of the result reads a band of TILE rows of the matrix, instead of every row per diagonal
+    #pragma omp parallel for collapse(2) schedule(static)
+    for (size_t i0 = 0; i0 < numRows; i0 += TILE) {
+        for (size_t j0 = 0; j0 < numCols; j0 += TILE) {
+            for (size_t i = i0; i < std::min(i0 + TILE, numRows); i++) {
+                double* row = result[i].data();
 
-            row.push_back(matrix[rowIndex][colIndex]);
+                for (size_t j = j0; j < std::min(j0 + TILE, numCols); j++)
+                    row[j] = matrix[j % numRows][(j + i) % numCols];
+            }
         }
-        result.push_back(row);
     }
 
     return result;
 }
+
+
+/***
+ * Diagonal and slot of the entry in row c and column r of a matrix of shape in x out for the banded method.
+ */
+static std::pair<unsigned int, unsigned int> banded_position(size_t c, size_t r, uint32_t batchSize) {
+    //  The input matrix is of shape in x out, so entry [c][r] belongs to row r and column c of the out x in matrix
+    return {(c + batchSize - r) % batchSize, r};
+}
+
+
+/***
+ * Diagonal and slot of the entry in row c and column r of a matrix of shape in x out for the hybrid method.
+ */
+static std::pair<unsigned int, unsigned int> hybrid_position(size_t c, size_t r, unsigned int dIn, unsigned int dOut,
+                                                             uint32_t batchSize) {
+    //  Exactly one slot j = r + q * dOut with j < dIn reads column c through an offset i < dOut
+    unsigned int u = (c + dIn - r) % dIn;
+    unsigned int i = u % dOut;
+    unsigned int j = r + (u - i);
+
+    unsigned int offset = j + i < dIn ? i : (i + batchSize - dIn) % batchSize;
+
+    return {offset, j};
+}
+
+
+std::vector<unsigned int> banded_offsets(const Tensor& matrix, uint32_t batchSize) {
+    return mark_offsets(matrix, batchSize, [batchSize](size_t c, size_t r) {
+        return banded_position(c, r, batchSize);
+    });
+}
+
+
+std::map<unsigned int, std::vector<double>> banded_diagonals(const Tensor& matrix, uint32_t batchSize) {
+    return extract_diagonals(matrix, batchSize, [batchSize](size_t c, size_t r) {
+        return banded_position(c, r, batchSize);
+    });
+}
+
+
+std::vector<unsigned int> hybrid_offsets(const Tensor& matrix, uint32_t batchSize) {
+    unsigned int dOut = next_power2(matrix.cols());
+    unsigned int dIn = next_power2(matrix.rows());
+
+    return mark_offsets(matrix, batchSize, [dIn, dOut, batchSize](size_t c, size_t r) {
+        return hybrid_position(c, r, dIn, dOut, batchSize);
+    });
+}
+
+
+std::map<unsigned int, std::vector<double>> hybrid_diagonals(const Tensor& matrix, uint32_t batchSize) {
+    unsigned int dOut = next_power2(matrix.cols());
+    unsigned int dIn = next_power2(matrix.rows());
+
+    return extract_diagonals(matrix, batchSize, [dIn, dOut, batchSize](size_t c, size_t r) {
+        return hybrid_position(c, r, dIn, dOut, batchSize);
+    });
+}
+
+
+nn::SlotLayout convolution_output_layout(const nn::Conv2DParams& params, const nn::SlotLayout& inputLayout,
+                                         uint32_t batchSize, const std::string& name) {
+    if (inputLayout.channels != params.inChannels || inputLayout.height != params.height
+        || inputLayout.width != params.width) {
+        std::cerr << name << ": Input layout does not match the input shape of the operation." << std::endl;
+        exit(1);
+    }
+
+    if (params.height + 2 * params.padding < params.kernelHeight || params.width + 2 * params.padding < params.kernelWidth) {
+        std::cerr << name << ": Kernel is larger than the padded input." << std::endl;
+        exit(1);
+    }
+
+    uint32_t outHeight = (params.height + 2 * params.padding - params.kernelHeight) / params.stride + 1;
+    uint32_t outWidth = (params.width + 2 * params.padding - params.kernelWidth) / params.stride + 1;
+
+    //  Every output entry needs the grid position of the input entry it is anchored to
+    if (outHeight * params.stride > params.height || outWidth * params.stride > params.width) {
+        std::cerr << name << ": The output does not fit into the grid of the input. Use less padding or the matrix "
+                  << "constructor." << std::endl;
+        exit(1);
+    }
+
+    nn::SlotLayout outputLayout = {params.outChannels, outHeight, outWidth, inputLayout.gap * params.stride,
+                                   inputLayout.rowPitch, inputLayout.blockSize};
+
+    if (inputLayout.size() > batchSize || outputLayout.size() > batchSize) {
+        std::cerr << name << ": Input or output does not fit into the batch size " << batchSize << "." << std::endl;
+        exit(1);
+    }
+
+    return outputLayout;
+}
+
+
+std::map<unsigned int, std::vector<double>> convolution_diagonals(const std::vector<double>& kernel,
+                                                                  const nn::Conv2DParams& params,
+                                                                  const nn::SlotLayout& inputLayout,
+                                                                  const nn::SlotLayout& outputLayout,
+                                                                  uint32_t batchSize, bool depthwise) {
+    std::map<unsigned int, std::vector<double>> diagonals;
+    uint32_t kernelChannels = depthwise ? 1 : params.inChannels;
+
+    for (uint32_t co = 0; co < outputLayout.channels; co++)
+        for (uint32_t oy = 0; oy < outputLayout.height; oy++)
+            for (uint32_t ox = 0; ox < outputLayout.width; ox++) {
+                uint32_t out = outputLayout.slot(co, oy, ox);
+
+                for (uint32_t k = 0; k < kernelChannels; k++)
+                    for (uint32_t ky = 0; ky < params.kernelHeight; ky++)
+                        for (uint32_t kx = 0; kx < params.kernelWidth; kx++) {
+                            int64_t y = (int64_t) oy * params.stride + ky - params.padding;
+                            int64_t x = (int64_t) ox * params.stride + kx - params.padding;
+
+                            //  Zero padding
+                            if (y < 0 || y >= params.height || x < 0 || x >= params.width)
+                                continue;
+
+                            double weight = kernel[((co * kernelChannels + k) * params.kernelHeight + ky)
+                                                   * params.kernelWidth + kx];
+                            if (weight == 0)
+                                continue;
+
+                            uint32_t ci = depthwise ? co : k;
+                            uint32_t in = inputLayout.slot(ci, y, x);
+                            unsigned int offset = (in + batchSize - out) % batchSize;
+
+                            auto& diagonal = diagonals[offset];
+                            if (diagonal.empty())
+                                diagonal.resize(batchSize, 0);
+
+                            diagonal[out] = weight;
+                        }
+            }
+
+    return diagonals;
+}
+
+
+std::map<unsigned int, std::vector<double>> relayout_diagonals(const nn::SlotLayout& from, const nn::SlotLayout& to,
+                                                               uint32_t offsetY, uint32_t offsetX, uint32_t batchSize) {
+    std::map<unsigned int, std::vector<double>> diagonals;
+
+    for (uint32_t c = 0; c < from.channels; c++)
+        for (uint32_t y = 0; y < from.height; y++)
+            for (uint32_t x = 0; x < from.width; x++) {
+                uint32_t in = from.slot(c, y, x);
+                uint32_t out = to.slot(c, y + offsetY, x + offsetX);
+                unsigned int offset = (in + batchSize - out) % batchSize;
+
+                auto& diagonal = diagonals[offset];
+                if (diagonal.empty())
+                    diagonal.resize(batchSize, 0);
+
+                diagonal[out] = 1;
+            }
+
+    return diagonals;
+}
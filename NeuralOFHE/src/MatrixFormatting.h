@@ -13,8 +13,13 @@
 #define TEST_MNIST_MATRIXFORMATTING_H
 
 #include <vector>
+#include <map>
 #include <math.h>
 #include <cstdint>
+#include <string>
+
+#include "NeuralOFHE/Operators/SlotLayout.h"
+#include "NeuralOFHE/Tensor.h"
 
 
 /**
@@ -22,7 +27,7 @@
  *
  * @param matrix Input matrix that should be transposed.
  */
-std::vector<std::vector<double>> transpose(std::vector<std::vector<double>> matrix);
+std::vector<std::vector<double>> transpose(const std::vector<std::vector<double>>& matrix);
 
 
 /**
@@ -41,7 +46,7 @@ unsigned int next_power2 (unsigned int n);
  * @param numCols The number of columns which the new matrix should have
  * @param numRows The number of rows which the new matrix should have
  */
-std::vector<std::vector<double>> resizeMatrix(std::vector<std::vector<double>> matrix, size_t numCols, size_t numRows);
+std::vector<std::vector<double>> resizeMatrix(const std::vector<std::vector<double>>& matrix, size_t numCols, size_t numRows);
 
 
 /**
@@ -61,4 +66,95 @@ unsigned int find_n1(uint32_t batchSize);
 std::vector<std::vector<double>> diagonal_transformation(const std::vector<std::vector<double>>& matrix);
 
 
+/**
+ * Function that returns the non-zero generalized diagonals of a rectangular matrix of shape out x in, embedded into a
+ * batchSize x batchSize matrix. Diagonal t holds the entry matrix[r][(r + t) % batchSize] at slot r, therefore only the
+ * offsets t in [0, in) and [batchSize - out + 1, batchSize) can be non-zero.
+ *
+ * @param matrix Input matrix of shape input size x output size, i.e. the transpose of the out x in matrix
+ * @param batchSize Number of slots of the ciphertexts the matrix will be multiplied with
+ */
+std::map<unsigned int, std::vector<double>> banded_diagonals(const Tensor& matrix, uint32_t batchSize);
+
+
+/**
+ * Function that returns the offsets of the diagonals banded_diagonals would return, without allocating them.
+ *
+ * @param matrix Input matrix of shape input size x output size
+ * @param batchSize Number of slots of the ciphertexts the matrix will be multiplied with
+ */
+std::vector<unsigned int> banded_offsets(const Tensor& matrix, uint32_t batchSize);
+
+
+/**
+ * Function that returns the non-zero diagonals of the hybrid diagonal method for a wide matrix of shape out x in with
+ * out < in. With dOut and dIn being the next powers of two of both dimensions, slot j of diagonal i holds the entry
+ * matrix[j % dOut][(j + i) % dIn] for j < dIn. Entries with j + i >= dIn are stored on the offset i - dIn instead, so
+ * that the input does not need to be replicated. Summing the slots j, j + dOut, j + 2 dOut, ... of the product yields
+ * the result.
+ *
+ * @param matrix Input matrix of shape input size x output size, i.e. the transpose of the out x in matrix
+ * @param batchSize Number of slots of the ciphertexts the matrix will be multiplied with
+ */
+std::map<unsigned int, std::vector<double>> hybrid_diagonals(const Tensor& matrix, uint32_t batchSize);
+
+
+/**
+ * Function that returns the offsets of the diagonals hybrid_diagonals would return, without allocating them.
+ *
+ * @param matrix Input matrix of shape input size x output size
+ * @param batchSize Number of slots of the ciphertexts the matrix will be multiplied with
+ */
+std::vector<unsigned int> hybrid_offsets(const Tensor& matrix, uint32_t batchSize);
+
+
+/**
+ * Function that returns the layout of the output of a convolution or pooling window on an input with the given layout.
+ * The output entry (y, x) is stored on the grid position of the input entry (y * stride, x * stride), i.e. the gap of
+ * the input is multiplied by the stride. Prints an error and exits if the shapes do not match or do not fit into the
+ * batch size.
+ *
+ * @param params Shape of the window operation
+ * @param inputLayout Layout of the input
+ * @param batchSize Number of slots of the ciphertexts
+ * @param name Name of the operator that is used in error messages
+ */
+nn::SlotLayout convolution_output_layout(const nn::Conv2DParams& params, const nn::SlotLayout& inputLayout,
+                                         uint32_t batchSize, const std::string& name);
+
+
+/**
+ * Function that returns the non-zero diagonals of a convolution. Every weight shifts its input entry by an amount that
+ * only depends on the channels and the kernel offset, so weights with the same shift share a diagonal. Weights that
+ * would read from the zero padding are left out.
+ *
+ * @param kernel Flattened kernel of shape outChannels x inChannels x kernelHeight x kernelWidth, or of shape
+ * outChannels x 1 x kernelHeight x kernelWidth for a depthwise convolution
+ * @param params Shape of the convolution
+ * @param inputLayout Layout of the input
+ * @param outputLayout Layout of the output as returned by convolution_output_layout
+ * @param batchSize Number of slots of the ciphertexts
+ * @param depthwise Whether every output channel only depends on the input channel with the same index
+ */
+std::map<unsigned int, std::vector<double>> convolution_diagonals(const std::vector<double>& kernel,
+                                                                  const nn::Conv2DParams& params,
+                                                                  const nn::SlotLayout& inputLayout,
+                                                                  const nn::SlotLayout& outputLayout,
+                                                                  uint32_t batchSize, bool depthwise = false);
+
+
+/**
+ * Function that returns the non-zero diagonals of the map moving entry (c, y, x) of the layout from to the entry
+ * (c, y + offsetY, x + offsetX) of the layout to. All other entries of to are zero.
+ *
+ * @param from Layout of the input
+ * @param to Layout of the output, which has to be large enough for the moved entries
+ * @param offsetY Offset that is added to the row of every entry
+ * @param offsetX Offset that is added to the column of every entry
+ * @param batchSize Number of slots of the ciphertexts
+ */
+std::map<unsigned int, std::vector<double>> relayout_diagonals(const nn::SlotLayout& from, const nn::SlotLayout& to,
+                                                               uint32_t offsetY, uint32_t offsetX, uint32_t batchSize);
+
+
 #endif //TEST_MNIST_MATRIXFORMATTING_H
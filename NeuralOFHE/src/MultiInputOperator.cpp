@@ -0,0 +1,25 @@
+#include "NeuralOFHE/Operators/MultiInputOperator.h"
+#include "NeuralOFHE/Tracer.h"
+
+
+MultiInputOperator::MultiInputOperator(uint32_t& objCounter, std::string name) : Operator(objCounter, name) {
+
+}
+
+
+Ciphertext<DCRTPoly> MultiInputOperator::forward(Ciphertext<DCRTPoly> x) {
+    return forward(std::vector<Ciphertext<DCRTPoly>>{x});
+}
+
+
+Ciphertext<DCRTPoly> MultiInputOperator::evaluate(const std::vector<Ciphertext<DCRTPoly>>& inputs) {
+    if (!Profiler::isEnabled() && !Tracer::isEnabled())
+        return forward(inputs);
+
+    return profiled(inputs, [this, &inputs]() { return forward(inputs); });
+}
+
+
+size_t MultiInputOperator::getNumInputs() {
+    return 0;
+}
@@ -0,0 +1,295 @@
+#include "NeuralOFHE/Npy.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/***
+ * Read-only mapping of a whole file, which is unmapped once the last tensor on it is destroyed.
+ */
+struct FileMapping {
+    const char* address = nullptr;
+    size_t length = 0;
+
+    ~FileMapping() {
+        if (address != nullptr)
+            munmap(const_cast<char*>(address), length);
+    }
+};
+
+
+/***
+ * Prints an error about a .npy file and exits.
+ */
+[[noreturn]] static void npy_error(const std::string& path, const std::string& message) {
+    std::cerr << "Error loading " << path << ": " << message << std::endl;
+    exit(1);
+}
+
+
+/***
+ * Skips spaces in the header dictionary.
+ */
+static void skip_spaces(const std::string& header, size_t& position) {
+    while (position < header.size() && header[position] == ' ')
+        position++;
+}
+
+
+/***
+ * Parses the header dictionary of a .npy file, e.g. {'descr': '<f4', 'fortran_order': False, 'shape': (400, 128), }.
+ * Python literals other than strings, booleans and tuples of integers are rejected.
+ *
+ * @param dictionary Header dictionary
+ * @param path Path of the file, for error messages
+ * @param header Header whose descr, fortranOrder and shape are set
+ */
+static void parse_dictionary(const std::string& dictionary, const std::string& path, NpyHeader& header) {
+    size_t position = 0;
+    bool hasDescr = false, hasOrder = false, hasShape = false;
+
+    skip_spaces(dictionary, position);
+    if (position >= dictionary.size() || dictionary[position++] != '{')
+        npy_error(path, "the header is no dictionary");
+
+    while (true) {
+        skip_spaces(dictionary, position);
+        if (position < dictionary.size() && dictionary[position] == '}')
+            break;
+
+        if (position >= dictionary.size() || dictionary[position] != '\'')
+            npy_error(path, "malformed header dictionary");
+
+        size_t end = dictionary.find('\'', position + 1);
+        if (end == std::string::npos)
+            npy_error(path, "malformed header dictionary");
+        std::string key = dictionary.substr(position + 1, end - position - 1);
+
+        position = end + 1;
+        skip_spaces(dictionary, position);
+        if (position >= dictionary.size() || dictionary[position++] != ':')
+            npy_error(path, "malformed header dictionary");
+        skip_spaces(dictionary, position);
+
+        if (key == "descr") {
+            end = dictionary.find('\'', position + 1);
+            if (dictionary[position] != '\'' || end == std::string::npos)
+                npy_error(path, "descr has to be a string");
+
+            header.descr = dictionary.substr(position + 1, end - position - 1);
+            position = end + 1;
+            hasDescr = true;
+        }
+        else if (key == "fortran_order") {
+            if (dictionary.compare(position, 4, "True") == 0) {
+                header.fortranOrder = true;
+                position += 4;
+            }
+            else if (dictionary.compare(position, 5, "False") == 0) {
+                header.fortranOrder = false;
+                position += 5;
+            }
+            else
+                npy_error(path, "fortran_order has to be True or False");
+            hasOrder = true;
+        }
+        else if (key == "shape") {
+            end = dictionary.find(')', position);
+            if (dictionary[position] != '(' || end == std::string::npos)
+                npy_error(path, "shape has to be a tuple");
+
+            //  Entries separated by commas, with an optional trailing comma as in (400,)
+            for (position++; position < end;) {
+                skip_spaces(dictionary, position);
+                if (position == end)
+                    break;
+
+                size_t digits = dictionary.find_first_not_of("0123456789", position);
+                if (digits == position || digits > end)
+                    npy_error(path, "shape has to be a tuple of non-negative integers");
+
+                header.shape.push_back(std::stoull(dictionary.substr(position, digits - position)));
+
+                position = digits;
+                skip_spaces(dictionary, position);
+                if (dictionary[position] == ',')
+                    position++;
+                else if (position != end)
+                    npy_error(path, "shape has to be a tuple of non-negative integers");
+            }
+            position = end + 1;
+            hasShape = true;
+        }
+        else
+            npy_error(path, "unknown key '" + key + "' in the header");
+
+        skip_spaces(dictionary, position);
+        if (position < dictionary.size() && dictionary[position] == ',')
+            position++;
+        else if (position >= dictionary.size() || dictionary[position] != '}')
+            npy_error(path, "malformed header dictionary");
+    }
+
+    if (!hasDescr || !hasOrder || !hasShape)
+        npy_error(path, "the header needs the keys descr, fortran_order and shape");
+}
+
+
+size_t NpyHeader::itemSize() const {
+    return descr == "<f4" ? sizeof(float) : sizeof(double);
+}
+
+
+size_t NpyHeader::size() const {
+    size_t entries = 1;
+    for (auto dim : shape)
+        entries *= dim;
+
+    return entries;
+}
+
+
+NpyHeader ReadNpyHeader(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        npy_error(path, "the file cannot be opened");
+
+    unsigned char prefix[12];
+    file.read(reinterpret_cast<char*>(prefix), 10);
+    if (!file || std::memcmp(prefix, "\x93NUMPY", 6) != 0)
+        npy_error(path, "no .npy file");
+
+    //  Version 1 stores the length of the header in two bytes, versions 2 and 3 in four
+    uint8_t major = prefix[6];
+    size_t headerLength, prefixLength;
+    if (major == 1) {
+        headerLength = prefix[8] | (size_t) prefix[9] << 8;
+        prefixLength = 10;
+    }
+    else if (major == 2 || major == 3) {
+        file.read(reinterpret_cast<char*>(prefix) + 10, 2);
+        headerLength = prefix[8] | (size_t) prefix[9] << 8 | (size_t) prefix[10] << 16 | (size_t) prefix[11] << 24;
+        prefixLength = 12;
+    }
+    else
+        npy_error(path, "unsupported format version " + std::to_string(major));
+
+    std::string dictionary(headerLength, ' ');
+    file.read(dictionary.data(), headerLength);
+    if (!file || dictionary.empty() || dictionary.back() != '\n')
+        npy_error(path, "truncated header");
+    dictionary.pop_back();
+
+    NpyHeader header;
+    parse_dictionary(dictionary, path, header);
+    header.dataOffset = prefixLength + headerLength;
+
+    if (header.descr != "<f4" && header.descr != "<f8")
+        npy_error(path, "unsupported dtype " + header.descr + ", expected <f4 or <f8");
+
+    return header;
+}
+
+
+Tensor LoadNpy(const std::string& path) {
+    NpyHeader header = ReadNpyHeader(path);
+    size_t size = header.size();
+
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        npy_error(path, "the file cannot be opened");
+
+    struct stat status{};
+    if (fstat(descriptor, &status) != 0) {
+        close(descriptor);
+        npy_error(path, "the size of the file is unknown");
+    }
+
+    size_t expected = header.dataOffset + size * header.itemSize();
+    if ((size_t) status.st_size != expected) {
+        close(descriptor);
+        npy_error(path, "the file has " + std::to_string(status.st_size) + " bytes, but its shape requires " +
+                        std::to_string(expected));
+    }
+
+    auto mapping = std::make_shared<FileMapping>();
+    mapping->length = expected;
+    void* address = mmap(nullptr, expected, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+
+    if (address == MAP_FAILED)
+        npy_error(path, "the file cannot be mapped into memory");
+    mapping->address = static_cast<const char*>(address);
+
+    const char* entries = mapping->address + header.dataOffset;
+    bool contiguous = !header.fortranOrder || header.shape.size() < 2;
+
+    //  The data offset is a multiple of 64 for files written by numpy, so the doubles can be read in place
+    if (header.descr == "<f8" && contiguous && header.dataOffset % alignof(double) == 0) {
+        madvise(const_cast<char*>(mapping->address), expected, MADV_WILLNEED);
+        std::shared_ptr<const double> data(mapping, reinterpret_cast<const double*>(entries));
+
+        return Tensor(header.shape, std::move(data));
+    }
+
+    madvise(const_cast<char*>(mapping->address), expected, MADV_SEQUENTIAL);
+
+    auto read = [&](size_t i) {
+        if (header.descr == "<f4") {
+            float value;
+            std::memcpy(&value, entries + i * sizeof(float), sizeof(float));
+            return (double) value;
+        }
+
+        double value;
+        std::memcpy(&value, entries + i * sizeof(double), sizeof(double));
+        return value;
+    };
+
+    std::vector<double> values(size);
+    if (contiguous) {
+        #pragma omp parallel for
+        for (size_t i = 0; i < size; i++)
+            values[i] = read(i);
+    }
+    else {
+        //  In fortran order the first index is the fastest, i.e. the entry at index (i_0, ..., i_n) lies at the sum of
+        //  i_k times the product of the sizes of the dimensions before k
+        const auto& shape = header.shape;
+        size_t numDims = shape.size();
+        std::vector<size_t> strides(numDims, 1);
+        for (size_t k = 1; k < numDims; k++)
+            strides[k] = strides[k - 1] * shape[k - 1];
+
+        size_t rowSize = shape[0] == 0 ? 0 : size / shape[0];
+
+        #pragma omp parallel for
+        for (size_t i = 0; i < shape[0]; i++) {
+            //  Index into the remaining dimensions, which is advanced in row-major order
+            std::vector<size_t> index(numDims, 0);
+            size_t offset = i;
+
+            for (size_t j = 0; j < rowSize; j++) {
+                values[i * rowSize + j] = read(offset);
+
+                for (size_t k = numDims - 1; k > 0; k--) {
+                    offset += strides[k];
+                    if (++index[k] < shape[k])
+                        break;
+
+                    offset -= index[k] * strides[k];
+                    index[k] = 0;
+                }
+            }
+        }
+    }
+
+    return Tensor(header.shape, std::move(values));
+}
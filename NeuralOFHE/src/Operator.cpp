@@ -1,4 +1,15 @@
 #include "NeuralOFHE/Operators/Operator.h"
+#include "NeuralOFHE/Tracer.h"
+#include "PlaintextCache.h"
+
+#include <chrono>
+#include <mutex>
+
+
+struct ProfileState {
+    std::mutex mutex;
+    LayerProfile profile;
+};
 
 bool Operator::verbose = false;
 
@@ -6,12 +17,17 @@ bool Operator::verbose = false;
 CryptoContext<DCRTPoly> Operator::context = NULL;
 
 
-Operator::Operator() {}
+Operator::Operator() {
+    cache = std::make_shared<PlaintextCache>();
+    profile = std::make_shared<ProfileState>();
+}
 
 
 Operator::Operator(uint32_t& objectCounter, std::string name) {
     Operator::isInitialized();
     this->name = name;
+    cache = std::make_shared<PlaintextCache>();
+    profile = std::make_shared<ProfileState>();
     objectCounter++;
 }
 
@@ -21,6 +37,11 @@ void Operator::initialize(CryptoContext<lbcrypto::DCRTPoly> cc) {
 }
 
 
+CryptoContext<DCRTPoly> Operator::getContext() {
+    return context;
+}
+
+
 void Operator::isInitialized() {
     if (context == NULL) {
         std::cerr << "You first have to initialize a cryptocontext using the 'SetContext' function." << std::endl;
@@ -34,6 +55,93 @@ std::string Operator::getName() {
 }
 
 
+Ciphertext<DCRTPoly> Operator::evaluate(Ciphertext<DCRTPoly> x) {
+    if (!Profiler::isEnabled() && !Tracer::isEnabled())
+        return forward(x);
+
+    return profiled({x}, [this, &x]() { return forward(x); });
+}
+
+
+Ciphertext<DCRTPoly> Operator::profiled(const std::vector<Ciphertext<DCRTPoly>>& inputs,
+                                        const std::function<Ciphertext<DCRTPoly>()>& run) {
+    Tracer::Span span("operator", name);
+
+    LayerProfile record;
+    record.name = name;
+    record.calls = 1;
+
+    for (const auto& input : inputs) {
+        record.inputLevel = std::max<uint32_t>(record.inputLevel, input->GetLevel());
+        record.inputBytes += Profiler::ciphertextBytes(input);
+    }
+
+    uint64_t encodes = cache->getEncodes();
+    LayerProfile* outer = Profiler::setCurrent(&record);
+    auto start = std::chrono::steady_clock::now();
+
+    Ciphertext<DCRTPoly> output = run();
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    Profiler::setCurrent(outer);
+
+    //  Concurrent forward passes of the same operator share its cache, so their encodings can be attributed to either
+    record.seconds = elapsed.count();
+    record.encodes = cache->getEncodes() - encodes;
+    record.outputLevel = output->GetLevel();
+    record.outputBytes = Profiler::ciphertextBytes(output);
+    record.rescales = record.outputLevel > record.inputLevel ? record.outputLevel - record.inputLevel : 0;
+
+    Tracer::recordLatency(name, record.seconds);
+
+    if (Profiler::isEnabled()) {
+        std::lock_guard<std::mutex> lock(profile->mutex);
+        profile->profile.add(record);
+    }
+
+    return output;
+}
+
+
+LayerProfile Operator::getProfile() {
+    std::lock_guard<std::mutex> lock(profile->mutex);
+
+    LayerProfile result = profile->profile;
+    result.name = name;
+
+    return result;
+}
+
+
+void Operator::resetProfile() {
+    std::lock_guard<std::mutex> lock(profile->mutex);
+    profile->profile = LayerProfile();
+}
+
+
+void Operator::setCacheBudget(size_t bytes) {
+    cache->setBudget(bytes);
+}
+
+
+void Operator::warmUp(uint32_t /*level*/) {}
+
+
+std::vector<int> Operator::getRotationIndices() {
+    return {};
+}
+
+
+uint32_t Operator::getDepth() {
+    return 0;
+}
+
+
+uint32_t Operator::getOutputSize() {
+    return 0;
+}
+
+
 void Operator::setVerbosity(bool state) {
     verbose = state;
 }
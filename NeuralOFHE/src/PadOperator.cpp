@@ -1,8 +1,121 @@
 #include "NeuralOFHE/Operators/PadOperator.h"
+#include "LinTools.h"
 
 uint32_t nn::PadOperator::numPadOperator = 0;
 
-nn::PadOperator::PadOperator(matVec matrix, std::vector<double> bias) : 
-    GeneralLinearOperator(matrix, bias, numPadOperator, "PadOperator_" + std::to_string(numPadOperator)) {
+nn::PadOperator::PadOperator(Tensor matrix, std::vector<double> bias) : 
+    GeneralLinearOperator(std::move(matrix), std::move(bias), numPadOperator, "PadOperator_" + std::to_string(numPadOperator)) {
+    outputLayout = SlotLayout::dense(1, 1, weights.cols());
+}
+
+
+nn::PadOperator::PadOperator(PadParams params) :
+    PadOperator(params, SlotLayout::dense(params.channels, params.height, params.width)) {
+
+}
+
+
+nn::PadOperator::PadOperator(PadParams params, SlotLayout inputLayout) :
+    GeneralLinearOperator(numPadOperator, "PadOperator_" + std::to_string(numPadOperator)) {
+    uint32_t batchSize = context->GetEncodingParams()->GetBatchSize();
+
+    if (inputLayout.channels != params.channels || inputLayout.height != params.height
+        || inputLayout.width != params.width) {
+        std::cerr << name << ": Input layout does not match the input shape of the padding." << std::endl;
+        exit(1);
+    }
+
+    uint32_t outHeight = params.height + params.top + params.bottom;
+    uint32_t outWidth = params.width + params.left + params.right;
+
+    //  The padded image fits into the grid of the input if the rows and blocks of the layout leave enough room
+    bool fitsGrid = outWidth * inputLayout.gap <= inputLayout.rowPitch
+                    && outHeight * inputLayout.gap * inputLayout.rowPitch <= inputLayout.blockSize;
+
+    if (fitsGrid) {
+        outputLayout = {params.channels, outHeight, outWidth, inputLayout.gap, inputLayout.rowPitch,
+                        inputLayout.blockSize};
+    } else {
+        outputLayout = SlotLayout::dense(params.channels, outHeight, outWidth);
+    }
+
+    if (inputLayout.size() > batchSize || outputLayout.size() > batchSize) {
+        std::cerr << name << ": Input or output of the padding does not fit into the batch size " << batchSize << "."
+                  << std::endl;
+        exit(1);
+    }
+
+    if (!fitsGrid) {
+        schedule = std::make_shared<DiagonalSchedule>(make_diagonal_schedule(
+                relayout_diagonals(inputLayout, outputLayout, params.top, params.left, batchSize), batchSize,
+                outputLayout.size()));
+        return;
+    }
+
+    //  Every entry moves by the same number of slots to the right, which is a rotation to the left by the rest of the
+    //  batch
+    uint32_t shift = outputLayout.slot(0, params.top, params.left) - inputLayout.slot(0, 0, 0);
+    rotation = (batchSize - shift % batchSize) % batchSize;
+
+    mask.assign(outputLayout.size(), 0);
+    for (uint32_t c = 0; c < params.channels; c++)
+        for (uint32_t y = 0; y < params.height; y++)
+            for (uint32_t x = 0; x < params.width; x++)
+                mask[outputLayout.slot(c, y + params.top, x + params.left)] = 1;
+}
+
+
+Ciphertext<DCRTPoly> nn::PadOperator::forward(Ciphertext<DCRTPoly> x) {
+    if (mask.empty())
+        return GeneralLinearOperator::forward(x);
+
+    if (rotation != 0) {
+        x = context->EvalRotate(x, rotation);
+        Profiler::count(&LayerProfile::rotations);
+        Profiler::count(&LayerProfile::keySwitches);
+    }
+
+    Plaintext pl = cache->get(0, mask, x, context);
+    x = context->EvalMult(x, pl);
+    Profiler::count(&LayerProfile::plainMults);
+
+    store_output_size(x, outputLayout.size());
+
+    return x;
+}
+
+
+void nn::PadOperator::warmUp(uint32_t level) {
+    if (mask.empty()) {
+        GeneralLinearOperator::warmUp(level);
+        return;
+    }
+
+    cache->warmUp({{0, &mask}}, level, context);
+}
+
+
+std::vector<int> nn::PadOperator::getRotationIndices() {
+    if (mask.empty())
+        return GeneralLinearOperator::getRotationIndices();
+
+    if (rotation == 0)
+        return {};
+
+    return {(int) rotation};
+}
+
+
+uint32_t nn::PadOperator::getOutputSize() {
+    return outputLayout.size();
+}
+
+
+nn::SlotLayout nn::PadOperator::getOutputLayout() {
+    return outputLayout;
+}
+
 
+std::vector<uint32_t> nn::PadOperator::getOutputSlots() {
+    return outputLayout.slots();
 }
@@ -0,0 +1,267 @@
+#include "NeuralOFHE/Pipeline.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+
+/***
+ * Request on its way through the stages.
+ */
+struct Request {
+    Ciphertext<DCRTPoly> x;
+    std::promise<Ciphertext<DCRTPoly>> result;
+};
+
+
+/***
+ * Stage of the pipeline together with the bounded queue in front of it.
+ */
+struct Pipeline::Stage {
+    std::vector<std::shared_ptr<Operator>> layers;
+    PipelineStage config;
+
+    mutable std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    std::deque<Request> queue;
+    size_t capacity;
+    bool closed = false;
+
+    size_t processed = 0;
+    std::chrono::steady_clock::duration busy{0};
+    std::chrono::steady_clock::time_point start;
+
+    std::thread thread;
+
+    /***
+     * Appends a request, blocks as long as the queue is full.
+     */
+    void push(Request request) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this]() { return queue.size() < capacity; });
+
+        queue.push_back(std::move(request));
+        lock.unlock();
+
+        notEmpty.notify_one();
+    }
+
+    /***
+     * Takes the next request, blocks until there is one. Returns false once the queue is closed and empty.
+     */
+    bool pop(Request& request) {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this]() { return closed || !queue.empty(); });
+
+        if (queue.empty())
+            return false;
+
+        request = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+
+        notFull.notify_one();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+
+        notEmpty.notify_all();
+    }
+};
+
+
+Pipeline::Pipeline(const std::shared_ptr<Application>& application, size_t queueCapacity)
+        : Pipeline(application, std::vector<PipelineStage>(application->getLayers().size()), queueCapacity) {}
+
+
+Pipeline::Pipeline(const std::shared_ptr<Application>& application, const std::vector<PipelineStage>& stages,
+                   size_t queueCapacity) {
+    this->application = application;
+
+    if (application->isGraph()) {
+        std::cerr << "Pipeline: applications built from a graph cannot be pipelined" << std::endl;
+        exit(1);
+    }
+
+    const auto& layers = application->getLayers();
+
+    size_t total = 0;
+    for (const auto& config : stages) {
+        if (config.numLayers == 0) {
+            std::cerr << "Pipeline: every stage needs at least one layer" << std::endl;
+            exit(1);
+        }
+        total += config.numLayers;
+    }
+
+    if (total != layers.size() || stages.empty()) {
+        std::cerr << "Pipeline: the stages cover " << total << " layers, but the application has " << layers.size()
+                  << std::endl;
+        exit(1);
+    }
+
+    #ifdef _OPENMP
+    int cores = omp_get_max_threads();
+    #else
+    int cores = 1;
+    #endif
+
+    auto start = std::chrono::steady_clock::now();
+    size_t first = 0;
+
+    for (const auto& config : stages) {
+        auto stage = std::make_unique<Stage>();
+        stage->layers.assign(layers.begin() + first, layers.begin() + first + config.numLayers);
+        stage->config = config;
+
+        if (config.threads <= 0)
+            stage->config.threads = std::max(cores / (int) stages.size(), 1);
+        stage->capacity = std::max<size_t>(queueCapacity, 1);
+        stage->start = start;
+
+        this->stages.push_back(std::move(stage));
+        first += config.numLayers;
+    }
+
+    //  Threads are started once all stages exist, as every stage pushes into the next one
+    for (size_t i = 0; i < this->stages.size(); i++)
+        this->stages[i]->thread = std::thread(&Pipeline::run, this, i);
+}
+
+
+Pipeline::~Pipeline() {
+    close();
+}
+
+
+std::future<Ciphertext<DCRTPoly>> Pipeline::submit(Ciphertext<DCRTPoly> x) {
+    if (closed) {
+        std::cerr << "Pipeline: cannot submit to a closed pipeline" << std::endl;
+        exit(1);
+    }
+
+    Request request;
+    request.x = std::move(x);
+    std::future<Ciphertext<DCRTPoly>> result = request.result.get_future();
+
+    stages.front()->push(std::move(request));
+
+    return result;
+}
+
+
+void Pipeline::close() {
+    //  Only the first of several concurrent calls joins the threads
+    if (closed.exchange(true))
+        return;
+
+    //  Every stage closes the next one once it has drained its own queue
+    stages.front()->close();
+
+    for (auto& stage : stages)
+        stage->thread.join();
+}
+
+
+std::vector<PipelineStageStats> Pipeline::getStats() const {
+    auto now = std::chrono::steady_clock::now();
+
+    std::vector<PipelineStageStats> stats;
+    for (const auto& stage : stages) {
+        std::lock_guard<std::mutex> lock(stage->mutex);
+
+        PipelineStageStats entry;
+        for (const auto& layer : stage->layers)
+            entry.name += (entry.name.empty() ? "" : " -> ") + layer->getName();
+
+        entry.queueDepth = stage->queue.size();
+        entry.queueCapacity = stage->capacity;
+        entry.processed = stage->processed;
+
+        std::chrono::duration<double> elapsed = now - stage->start;
+        std::chrono::duration<double> busy = stage->busy;
+        entry.utilization = elapsed.count() > 0 ? busy.count() / elapsed.count() : 0;
+
+        stats.push_back(entry);
+    }
+
+    return stats;
+}
+
+
+void Pipeline::run(size_t index) {
+    Stage& stage = *stages[index];
+
+    #ifdef __linux__
+    if (!stage.config.cores.empty()) {
+        cpu_set_t cores;
+        CPU_ZERO(&cores);
+        for (int core : stage.config.cores)
+            CPU_SET(core, &cores);
+
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cores) != 0)
+            std::cerr << "Pipeline: could not pin stage " << index << " to its cores" << std::endl;
+    }
+    #endif
+
+    //  The number of threads is an ICV of the stage thread, so it only limits the regions of this stage
+    #ifdef _OPENMP
+    omp_set_num_threads(std::max(stage.config.threads, 1));
+    #endif
+
+    Request request;
+    while (stage.pop(request)) {
+        auto begin = std::chrono::steady_clock::now();
+
+        //  A failed request is answered with its exception and skips the remaining stages, the stage keeps draining
+        //  its queue
+        bool failed = false;
+        Ciphertext<DCRTPoly> x = request.x;
+        try {
+            for (const auto& layer : stage.layers)
+                x = layer->evaluate(x);
+        } catch (...) {
+            request.result.set_exception(std::current_exception());
+            failed = true;
+        }
+
+        auto end = std::chrono::steady_clock::now();
+
+        {
+            std::lock_guard<std::mutex> lock(stage.mutex);
+            stage.busy += end - begin;
+            stage.processed++;
+        }
+
+        if (failed)
+            continue;
+
+        if (index + 1 < stages.size()) {
+            request.x = x;
+            stages[index + 1]->push(std::move(request));
+        } else {
+            request.result.set_value(x);
+        }
+    }
+
+    if (index + 1 < stages.size())
+        stages[index + 1]->close();
+}
@@ -0,0 +1,192 @@
+#include "PlaintextCache.h"
+#include "NeuralOFHE/Tracer.h"
+
+
+size_t PlaintextCache::defaultBudget = size_t(512) << 20;
+
+
+PlaintextCache::PlaintextCache(size_t budget) {
+    this->budget = budget;
+    this->size = 0;
+}
+
+
+size_t PlaintextCache::KeyHash::operator()(const Key& key) const {
+    size_t hash = std::hash<uint32_t>()(key.index);
+    hash ^= std::hash<uint32_t>()(key.level) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<double>()(key.scalingFactor) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<bool>()(key.extended) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+
+    return hash;
+}
+
+
+Plaintext PlaintextCache::get(uint32_t index, const std::vector<double>& values, const Ciphertext<DCRTPoly>& x,
+                              const CryptoContext<DCRTPoly>& context, bool extended) {
+    return get(index, values, multiplicationLevel(x, context), context, extended);
+}
+
+
+Plaintext PlaintextCache::get(uint32_t index, const std::vector<double>& values, uint32_t level,
+                              const CryptoContext<DCRTPoly>& context, bool extended) {
+    //  The scaling factor of a ciphertext can differ from that of its level, e.g. squared for a product that was not
+    //  rescaled yet. The plaintext is always encoded with the scaling factor of the level, so that is the key
+    auto cryptoParams = std::dynamic_pointer_cast<CryptoParametersCKKSRNS>(context->GetCryptoParameters());
+    Key key = {index, level, cryptoParams->GetScalingFactorReal(level), extended};
+    auto encoder = extended ? encodeExtended : encode;
+
+    {
+        //  Waiting for the lock is traced on its own, so that contention between threads shows up
+        std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+        {
+            Tracer::Span wait("lock", "plaintext cache");
+            lock.lock();
+        }
+
+        if (budget == 0) {
+            encodes++;
+            return encoder(values, level, context);
+        }
+
+        auto it = lookup.find(key);
+        if (it != lookup.end()) {
+            entries.splice(entries.begin(), entries, it->second);
+            return it->second->plaintext;
+        }
+    }
+
+    //  Encoding is done without holding the lock, so that several threads can encode different plaintexts at once
+    Plaintext plaintext;
+    {
+        Tracer::Span span("encode", "encode", index);
+        plaintext = encoder(values, level, context);
+    }
+    encodes++;
+    size_t bytes = plaintext->GetElement<DCRTPoly>().GetNumOfElements() * context->GetRingDimension() * sizeof(uint64_t)
+            + values.size() * sizeof(std::complex<double>);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    //  Another thread might have encoded the same plaintext in the meantime
+    auto it = lookup.find(key);
+    if (it != lookup.end()) {
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->plaintext;
+    }
+
+    if (bytes > budget)
+        return plaintext;
+
+    entries.push_front({key, plaintext, bytes});
+    lookup[key] = entries.begin();
+    size += bytes;
+
+    evict();
+
+    return plaintext;
+}
+
+
+void PlaintextCache::warmUp(const std::vector<std::pair<uint32_t, const std::vector<double>*>>& entries, uint32_t level,
+                            const CryptoContext<DCRTPoly>& context, bool extended) {
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t i=0; i<entries.size(); i++)
+        get(entries[i].first, *entries[i].second, level, context, extended);
+}
+
+
+void PlaintextCache::setBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    budget = bytes;
+    evict();
+}
+
+
+size_t PlaintextCache::getBudget() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return budget;
+}
+
+
+uint64_t PlaintextCache::getEncodes() {
+    return encodes;
+}
+
+
+size_t PlaintextCache::getSize() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return size;
+}
+
+
+void PlaintextCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    lookup.clear();
+    size = 0;
+}
+
+
+void PlaintextCache::setDefaultBudget(size_t bytes) {
+    defaultBudget = bytes;
+}
+
+
+uint32_t PlaintextCache::multiplicationLevel(const Ciphertext<DCRTPoly>& x, const CryptoContext<DCRTPoly>& context) {
+    auto cryptoParams = std::dynamic_pointer_cast<CryptoParametersCKKSRNS>(context->GetCryptoParameters());
+
+    //  EvalMult and EvalAdd rescale such a ciphertext by one level before they use the plaintext
+    if (x->GetNoiseScaleDeg() > 1 && cryptoParams->GetScalingTechnique() != FIXEDMANUAL)
+        return x->GetLevel() + 1;
+
+    return x->GetLevel();
+}
+
+
+uint32_t PlaintextCache::productLevel(uint32_t level, const CryptoContext<DCRTPoly>& context) {
+    auto cryptoParams = std::dynamic_pointer_cast<CryptoParametersCKKSRNS>(context->GetCryptoParameters());
+
+    return cryptoParams->GetScalingTechnique() != FIXEDMANUAL ? level + 1 : level;
+}
+
+
+Plaintext PlaintextCache::encode(const std::vector<double>& values, uint32_t level,
+                                 const CryptoContext<DCRTPoly>& context) {
+    return context->MakeCKKSPackedPlaintext(values, 1, level);
+}
+
+
+Plaintext PlaintextCache::encodeExtended(const std::vector<double>& values, uint32_t level,
+                                         const CryptoContext<DCRTPoly>& context) {
+    auto cryptoParams = std::dynamic_pointer_cast<CryptoParametersCKKSRNS>(context->GetCryptoParameters());
+    const auto& paramsQ = context->GetElementParams()->GetParams();
+    const auto& paramsP = cryptoParams->GetParamsP()->GetParams();
+
+    //  Towers of Q that are dropped at the given level are left out, the primes of P are appended
+    size_t sizeQl = paramsQ.size() - level;
+    std::vector<NativeInteger> moduli;
+    std::vector<NativeInteger> roots;
+
+    for (size_t i=0; i<sizeQl; i++) {
+        moduli.push_back(paramsQ[i]->GetModulus());
+        roots.push_back(paramsQ[i]->GetRootOfUnity());
+    }
+
+    for (const auto& param : paramsP) {
+        moduli.push_back(param->GetModulus());
+        roots.push_back(param->GetRootOfUnity());
+    }
+
+    auto paramsQlP = std::make_shared<DCRTPoly::Params>(context->GetCyclotomicOrder(), moduli, roots);
+
+    return context->MakeCKKSPackedPlaintext(values, 1, level, paramsQlP);
+}
+
+
+void PlaintextCache::evict() {
+    while (size > budget && !entries.empty()) {
+        size -= entries.back().bytes;
+        lookup.erase(entries.back().key);
+        entries.pop_back();
+    }
+}
@@ -0,0 +1,201 @@
+/**
+ * @file PlaintextCache.h
+ *
+ * @brief Cache of encoded CKKS plaintexts used by the operators that multiply or add fixed plaintext vectors to their
+ * input. Function bodies are defined in src/PlaintextCache.cpp.
+ *
+ */
+
+#ifndef NEURALOFHE_PLAINTEXTCACHE_H
+#define NEURALOFHE_PLAINTEXTCACHE_H
+
+#include <vector>
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <limits>
+#include <unordered_map>
+
+#include "openfhe.h"
+
+using namespace lbcrypto;
+
+
+/***
+ * Least recently used cache of encoded plaintexts. Entries are keyed by an index chosen by the owning operator (e.g. the
+ * diagonal index), the level at which the plaintext is multiplied with a ciphertext, the scaling factor of that level
+ * and whether the plaintext is encoded in the extended basis QP used by double hoisting. Plaintexts are encoded at that
+ * level, so that multiplications at lower levels only work on the remaining towers. All methods can be called from
+ * multiple threads at the same time.
+ */
+class PlaintextCache {
+public:
+    /***
+     * Index reserved for the bias vector of an operator.
+     */
+    static constexpr uint32_t BIAS_INDEX = std::numeric_limits<uint32_t>::max();
+
+    /***
+     * Constructor of a cache with the given memory budget.
+     *
+     * @param budget Maximum number of bytes the cached plaintexts may occupy
+     */
+    PlaintextCache(size_t budget = defaultBudget);
+
+    /***
+     * Returns the plaintext belonging to the index, encoded for the level at which it is multiplied with the
+     * ciphertext x, see multiplicationLevel. The plaintext is encoded and stored on a cache miss.
+     *
+     * @param index Index of the plaintext within the owning operator
+     * @param values Values that are encoded on a cache miss
+     * @param x Ciphertext the plaintext will be used with
+     * @param context Cryptocontext of the application
+     * @param extended Whether the plaintext is encoded in the extended basis QP, see encodeExtended
+     * @return Encoded plaintext
+     */
+    Plaintext get(uint32_t index, const std::vector<double>& values, const Ciphertext<DCRTPoly>& x,
+                  const CryptoContext<DCRTPoly>& context, bool extended = false);
+
+    /***
+     * Overload of get for an explicit level, which is also used by warmUp. The entry is keyed by the level and the
+     * scaling factor that the context uses at that level.
+     */
+    Plaintext get(uint32_t index, const std::vector<double>& values, uint32_t level,
+                  const CryptoContext<DCRTPoly>& context, bool extended = false);
+
+    /***
+     * Encodes all given plaintexts in parallel, so that following calls of get for the same level are cache hits.
+     *
+     * @param entries Pairs of plaintext index and the values belonging to it
+     * @param level Level at which the plaintexts should be encoded
+     * @param context Cryptocontext of the application
+     * @param extended Whether the plaintexts are encoded in the extended basis QP
+     */
+    void warmUp(const std::vector<std::pair<uint32_t, const std::vector<double>*>>& entries, uint32_t level,
+                const CryptoContext<DCRTPoly>& context, bool extended = false);
+
+    /***
+     * Sets the memory budget of the cache. Entries are evicted right away if the cache is larger than the new budget.
+     * A budget of 0 disables caching.
+     *
+     * @param bytes New budget in bytes
+     */
+    void setBudget(size_t bytes);
+
+    size_t getBudget();
+
+    /***
+     * Getter for the number of bytes occupied by the cached plaintexts.
+     *
+     * @return Size in bytes
+     */
+    size_t getSize();
+
+    /***
+     * Getter for the number of plaintexts get has encoded so far, i.e. its cache misses.
+     *
+     * @return Number of encodings
+     */
+    uint64_t getEncodes();
+
+    void clear();
+
+    /***
+     * Sets the budget that is used for caches created from now on.
+     *
+     * @param bytes Budget in bytes
+     */
+    static void setDefaultBudget(size_t bytes);
+
+    /***
+     * Level at which OpenFHE multiplies the ciphertext x with a plaintext or adds one to it. With automatic rescaling
+     * a product that was not rescaled yet, e.g. the output of a plaintext multiplication under FLEXIBLEAUTO, is
+     * rescaled first, so its plaintexts belong to the next level. Warmed up entries therefore match the ciphertexts
+     * of every layer.
+     *
+     * @param x Ciphertext the plaintext will be used with
+     * @param context Cryptocontext of the application
+     * @return Level of the multiplication
+     */
+    static uint32_t multiplicationLevel(const Ciphertext<DCRTPoly>& x, const CryptoContext<DCRTPoly>& context);
+
+    /***
+     * Level at which a plaintext is added to the product of a ciphertext and a plaintext that were multiplied on the
+     * given level, e.g. a bias after the diagonals of a linear operator. With automatic rescaling the product is
+     * rescaled before the addition, see multiplicationLevel.
+     *
+     * @param level Level of the multiplication
+     * @param context Cryptocontext of the application
+     * @return Level of the addition
+     */
+    static uint32_t productLevel(uint32_t level, const CryptoContext<DCRTPoly>& context);
+
+    /***
+     * Encodes values as a plaintext at the given level without caching it.
+     *
+     * @param values Values that should be encoded
+     * @param level Level at which the plaintext is encoded
+     * @param context Cryptocontext of the application
+     * @return Encoded plaintext
+     */
+    static Plaintext encode(const std::vector<double>& values, uint32_t level, const CryptoContext<DCRTPoly>& context);
+
+    /***
+     * Encodes values as a plaintext in the extended basis QP, i.e. the towers of Q that are left at the given level and
+     * the special primes P of hybrid key switching. Such plaintexts can be multiplied with ciphertexts that are still
+     * in the extended basis after a hoisted key switch, without caching it.
+     *
+     * @param values Values that should be encoded
+     * @param level Level at which the plaintext is encoded
+     * @param context Cryptocontext of the application
+     * @return Encoded plaintext
+     */
+    static Plaintext encodeExtended(const std::vector<double>& values, uint32_t level,
+                                    const CryptoContext<DCRTPoly>& context);
+
+private:
+    struct Key {
+        uint32_t index;
+        uint32_t level;
+        double scalingFactor;
+        bool extended;
+
+        bool operator==(const Key& other) const {
+            return index == other.index && level == other.level && scalingFactor == other.scalingFactor
+                   && extended == other.extended;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry {
+        Key key;
+        Plaintext plaintext;
+        size_t bytes;
+    };
+
+    /***
+     * Removes least recently used entries until the cache fits into its budget. Has to be called with the mutex locked.
+     */
+    void evict();
+
+    std::mutex mutex;
+
+    /***
+     * Entries ordered from most to least recently used and an index into that list.
+     */
+    std::list<Entry> entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> lookup;
+
+    size_t budget;
+    size_t size;
+
+    std::atomic<uint64_t> encodes{0};
+
+    static size_t defaultBudget;
+};
+
+
+#endif //NEURALOFHE_PLAINTEXTCACHE_H
@@ -0,0 +1,290 @@
+#include "NeuralOFHE/Operators/Polynomial.h"
+
+#include <algorithm>
+#include <cmath>
+
+uint32_t nn::PolynomialActivation::numPolynomial = 0;
+uint32_t nn::Square::numSquare = 0;
+uint32_t nn::ScaledSquare::numScaledSquare = 0;
+
+
+/***
+ * Converts the coefficients of a Chebyshev series on [min, max] to the power basis of x.
+ */
+static std::vector<double> chebyshev_to_power(const std::vector<double>& chebyshev, double min, double max) {
+    size_t size = chebyshev.size();
+
+    //  Power basis of T_k(t), built by T_k+1 = 2t T_k - T_k-1, summed up in t
+    std::vector<double> inT(size, .0);
+    std::vector<double> previous(size, .0), current(size, .0);
+    previous[0] = 1;
+    if (size > 1)
+        current[1] = 1;
+
+    inT[0] = chebyshev[0] / 2;
+    for (size_t k = 1; k < size; k++) {
+        for (size_t i = 0; i < size; i++)
+            inT[i] += chebyshev[k] * current[i];
+
+        std::vector<double> next(size, .0);
+        for (size_t i = 0; i + 1 < size; i++)
+            next[i + 1] = 2 * current[i];
+        for (size_t i = 0; i < size; i++)
+            next[i] -= previous[i];
+
+        previous = std::move(current);
+        current = std::move(next);
+    }
+
+    //  Substituting t = alpha x + beta by Horner's method
+    double alpha = 2 / (max - min);
+    double beta = -(max + min) / (max - min);
+
+    std::vector<double> result(size, .0);
+    for (size_t k = size; k-- > 0;) {
+        std::vector<double> shifted(size, .0);
+        for (size_t i = 0; i < size; i++) {
+            shifted[i] += beta * result[i];
+            if (i + 1 < size)
+                shifted[i + 1] += alpha * result[i];
+        }
+
+        shifted[0] += inT[k];
+        result = std::move(shifted);
+    }
+
+    return result;
+}
+
+
+/***
+ * Factors of the product tree of the monomial c x^k: their exponent and their depth. c x has depth 1 unless c is +-1,
+ * x^(2^i) has depth i.
+ */
+static std::vector<std::pair<uint32_t, uint32_t>> monomial_factors(uint32_t k, double c) {
+    std::vector<std::pair<uint32_t, uint32_t>> factors;
+
+    uint32_t rest = k;
+    if (std::abs(c) != 1) {
+        factors.push_back({1, 1});
+        rest--;
+    }
+
+    for (uint32_t i = 0; (rest >> i) != 0; i++)
+        if ((rest >> i) & 1)
+            factors.push_back({1u << i, i});
+
+    return factors;
+}
+
+
+/***
+ * Depth of the product of factors with the given depths, if the two shallowest ones are always multiplied first.
+ */
+static uint32_t product_depth(std::vector<uint32_t> depths) {
+    std::sort(depths.begin(), depths.end(), std::greater<uint32_t>());
+
+    while (depths.size() > 1) {
+        uint32_t a = depths.back();
+        depths.pop_back();
+        uint32_t b = depths.back();
+        depths.pop_back();
+
+        depths.push_back(std::max(a, b) + 1);
+        std::sort(depths.begin(), depths.end(), std::greater<uint32_t>());
+    }
+
+    return depths.empty() ? 0 : depths[0];
+}
+
+
+static std::vector<double> power_basis(std::vector<double> coefficients, nn::PolynomialBasis basis, double min,
+                                       double max) {
+    if (basis == nn::PolynomialBasis::CHEBYSHEV)
+        coefficients = chebyshev_to_power(coefficients, min, max);
+
+    while (!coefficients.empty() && coefficients.back() == 0)
+        coefficients.pop_back();
+
+    return coefficients;
+}
+
+
+nn::PolynomialActivation::PolynomialActivation(std::vector<double> coefficients, PolynomialBasis basis, double min,
+                                               double max)
+: ActivationFunction(min, max, std::max<size_t>(coefficients.size(), 1) - 1, numPolynomial,
+                     "Polynomial_" + std::to_string(numPolynomial)) {
+    if (basis == PolynomialBasis::CHEBYSHEV && !(min < max)) {
+        std::cerr << name << ": The interval [" << min << ", " << max << "] of the Chebyshev basis is empty."
+                  << std::endl;
+        exit(1);
+    }
+
+    power = power_basis(std::move(coefficients), basis, min, max);
+
+    std::vector<double> p = power;
+    polynomial = [p] (double x) -> double {
+        double result = 0;
+        for (size_t k = p.size(); k-- > 0;)
+            result = result * x + p[k];
+        return result;
+    };
+}
+
+
+nn::PolynomialActivation::PolynomialActivation(std::vector<double> coefficients, uint32_t& objCounter, std::string name)
+: ActivationFunction(-1, 1, std::max<size_t>(coefficients.size(), 1) - 1, objCounter, name) {
+    power = power_basis(std::move(coefficients), PolynomialBasis::POWER, -1, 1);
+
+    std::vector<double> p = power;
+    polynomial = [p] (double x) -> double {
+        double result = 0;
+        for (size_t k = p.size(); k-- > 0;)
+            result = result * x + p[k];
+        return result;
+    };
+}
+
+
+const std::function<double (double)> &nn::PolynomialActivation::getFunc() {
+    return polynomial;
+}
+
+
+const std::vector<double>& nn::PolynomialActivation::getPowerCoefficients() {
+    return power;
+}
+
+
+Ciphertext<DCRTPoly> nn::PolynomialActivation::forward(Ciphertext<DCRTPoly> x) {
+    //  Powers x^(2^i) by repeated squaring, each one level deeper than the last. Only computed once a monomial needs them
+    std::vector<Ciphertext<DCRTPoly>> squares = {x};
+    auto square = [&](uint32_t i) {
+        while (squares.size() <= i) {
+            squares.push_back(context->EvalSquare(squares.back()));
+            Profiler::count(&LayerProfile::cipherMults);
+            Profiler::count(&LayerProfile::keySwitches);
+        }
+        return squares[i];
+    };
+
+    Ciphertext<DCRTPoly> result;
+
+    for (uint32_t k = 1; k < power.size(); k++) {
+        double c = power[k];
+        if (c == 0)
+            continue;
+
+        //  Factors ordered by depth, the two shallowest ones are multiplied until one is left
+        std::vector<std::pair<uint32_t, Ciphertext<DCRTPoly>>> factors;
+        for (const auto& factor : monomial_factors(k, c)) {
+            if (factor.first == 1 && factor.second == 1) {
+                factors.push_back({1, context->EvalMult(x, c)});
+                Profiler::count(&LayerProfile::scalarMults);
+            } else
+                factors.push_back({factor.second, square(factor.second)});
+        }
+
+        auto deeper = [](const auto& a, const auto& b) { return a.first > b.first; };
+        std::sort(factors.begin(), factors.end(), deeper);
+
+        while (factors.size() > 1) {
+            auto a = factors.back();
+            factors.pop_back();
+            auto b = factors.back();
+            factors.pop_back();
+
+            factors.push_back({std::max(a.first, b.first) + 1, context->EvalMult(a.second, b.second)});
+            Profiler::count(&LayerProfile::cipherMults);
+            Profiler::count(&LayerProfile::keySwitches);
+            std::sort(factors.begin(), factors.end(), deeper);
+        }
+
+        Ciphertext<DCRTPoly> term = factors[0].second;
+        if (c == -1)
+            term = context->EvalNegate(term);
+
+        result = result ? context->EvalAdd(result, term) : term;
+    }
+
+    //  A constant polynomial still needs a ciphertext of the right shape
+    if (!result) {
+        result = context->EvalMult(x, 0.);
+        Profiler::count(&LayerProfile::scalarMults);
+    }
+
+    if (!power.empty() && power[0] != 0)
+        result = context->EvalAdd(result, power[0]);
+
+    return result;
+}
+
+
+uint32_t nn::PolynomialActivation::getDepth() {
+    uint32_t depth = 0;
+
+    for (uint32_t k = 1; k < power.size(); k++) {
+        if (power[k] == 0)
+            continue;
+
+        std::vector<uint32_t> depths;
+        for (const auto& factor : monomial_factors(k, power[k]))
+            depths.push_back(factor.second);
+
+        depth = std::max(depth, product_depth(depths));
+    }
+
+    //  Only the constant term, which forward multiplies x with zero for
+    if (power.size() <= 1)
+        return 1;
+
+    return depth;
+}
+
+
+nn::Square::Square() : PolynomialActivation({0, 0, 1}, numSquare, "Square_" + std::to_string(numSquare)) {
+
+}
+
+
+nn::ScaledSquare::ScaledSquare(double a, double b, double c)
+: PolynomialActivation({c, b, a}, numScaledSquare, "ScaledSquare_" + std::to_string(numScaledSquare)) {
+
+}
+
+
+double nn::ScaledSquare::getA() {
+    return power.size() > 2 ? power[2] : 0;
+}
+
+
+double nn::ScaledSquare::getB() {
+    return power.size() > 1 ? power[1] : 0;
+}
+
+
+double nn::ScaledSquare::getC() {
+    return power.empty() ? 0 : power[0];
+}
+
+
+bool nn::ScaledSquare::isNormalized() {
+    return std::abs(getA()) == 1 && getB() == 0;
+}
+
+
+std::shared_ptr<nn::ScaledSquare> nn::ScaledSquare::normalized(double& s, double& t) {
+    double a = getA();
+    double b = getB();
+
+    if (a == 0) {
+        std::cerr << name << ": Only activations with a quadratic term can be normalized." << std::endl;
+        exit(1);
+    }
+
+    //  a x^2 + b x + c = sign(a) (s x + t)^2 + c - b^2 / (4a)
+    s = std::sqrt(std::abs(a));
+    t = s * b / (2 * a);
+
+    return std::make_shared<ScaledSquare>(a > 0 ? 1 : -1, 0, getC() - b * b / (4 * a));
+}
@@ -0,0 +1,113 @@
+#include "NeuralOFHE/Profiler.h"
+
+#include <atomic>
+#include <iomanip>
+#include <sstream>
+
+
+static std::atomic<bool> enabled(false);
+
+static thread_local LayerProfile* current = nullptr;
+
+
+void LayerProfile::add(const LayerProfile& other) {
+    calls += other.calls;
+    seconds += other.seconds;
+    fastRotations += other.fastRotations;
+    rotations += other.rotations;
+    plainMults += other.plainMults;
+    cipherMults += other.cipherMults;
+    scalarMults += other.scalarMults;
+    rescales += other.rescales;
+    encodes += other.encodes;
+    keySwitches += other.keySwitches;
+    bootstraps += other.bootstraps;
+
+    inputLevel = other.inputLevel;
+    outputLevel = other.outputLevel;
+    inputBytes = other.inputBytes;
+    outputBytes = other.outputBytes;
+}
+
+
+void Profiler::setEnabled(bool state) {
+    enabled = state;
+}
+
+
+bool Profiler::isEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+
+void Profiler::count(uint64_t LayerProfile::*counter, uint64_t n) {
+    if (!isEnabled() || !current)
+        return;
+
+    current->*counter += n;
+}
+
+
+LayerProfile* Profiler::setCurrent(LayerProfile* profile) {
+    LayerProfile* previous = current;
+    current = profile;
+
+    return previous;
+}
+
+
+size_t Profiler::ciphertextBytes(const Ciphertext<DCRTPoly>& x) {
+    size_t bytes = 0;
+
+    for (const auto& element : x->GetElements())
+        bytes += element.GetNumOfElements() * element.GetRingDimension() * sizeof(uint64_t);
+
+    return bytes;
+}
+
+
+std::string Profiler::report(const std::vector<LayerProfile>& profiles) {
+    std::ostringstream stream;
+
+    stream << std::left << std::setw(24) << "layer" << std::right << std::setw(7) << "calls" << std::setw(11) << "ms/call"
+           << std::setw(7) << "share" << std::setw(8) << "fastRot" << std::setw(6) << "rot" << std::setw(8) << "ptMult"
+           << std::setw(8) << "ctMult" << std::setw(8) << "scMult" << std::setw(8) << "rescale" << std::setw(8)
+           << "encode" << std::setw(7) << "keySw" << std::setw(6) << "boot" << std::setw(9) << "levels"
+           << std::setw(11) << "out [MB]" << std::endl;
+
+    LayerProfile total;
+    total.name = "total";
+
+    for (const auto& profile : profiles)
+        total.add(profile);
+
+    auto row = [&](const LayerProfile& profile) {
+        double perCall = profile.calls ? 1e3 * profile.seconds / profile.calls : 0;
+        double share = total.seconds > 0 ? 100 * profile.seconds / total.seconds : 0;
+
+        std::ostringstream levels;
+        levels << profile.inputLevel << "->" << profile.outputLevel;
+
+        stream << std::left << std::setw(24) << profile.name << std::right << std::setw(7) << profile.calls
+               << std::setw(11) << std::fixed << std::setprecision(2) << perCall << std::setw(6)
+               << std::setprecision(1) << share << "%" << std::setw(8) << profile.fastRotations << std::setw(6)
+               << profile.rotations << std::setw(8) << profile.plainMults << std::setw(8) << profile.cipherMults
+               << std::setw(8) << profile.scalarMults << std::setw(8) << profile.rescales << std::setw(8)
+               << profile.encodes << std::setw(7) << profile.keySwitches << std::setw(6) << profile.bootstraps
+               << std::setw(9) << levels.str() << std::setw(11) << std::setprecision(2)
+               << profile.outputBytes / (1024. * 1024.) << std::endl;
+    };
+
+    for (const auto& profile : profiles)
+        row(profile);
+
+    //  Calls, levels and sizes of the total are those of the whole chain
+    if (!profiles.empty()) {
+        total.calls = profiles.front().calls;
+        total.inputLevel = profiles.front().inputLevel;
+        total.inputBytes = profiles.front().inputBytes;
+    }
+    row(total);
+
+    return stream.str();
+}
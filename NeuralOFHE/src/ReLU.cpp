@@ -5,6 +5,7 @@ uint32_t nn::ReLU::numReLU = 0;
 
 const std::function<double (double)> nn::ReLU::relu = [] (double x) -> double {return x <= 0 ? 0 : x;};
 const std::function<double(double)> &nn::ReLU::getFunc() {return relu;}
+std::string nn::ReLU::getFuncId() {return "ReLU";}
 
 
 nn::ReLU::ReLU(double min, double max, uint32_t polyDeg)
@@ -4,6 +4,7 @@ uint32_t nn::SiLU::numSiLU = 0;
 
 const std::function<double (double)> nn::SiLU::silu = [] (double x) -> double {return x / (1 + exp(-x));};
 const std::function<double (double)> &nn::SiLU::getFunc() {return silu;}
+std::string nn::SiLU::getFuncId() {return "SiLU";}
 
 
 nn::SiLU::SiLU(double min, double max, unsigned int polyDeg)
@@ -5,6 +5,7 @@ uint32_t nn::Sigmoid::numSigmoid = 0;
 
 const std::function<double (double)> nn::Sigmoid::sig = [] (double x) -> double {return 1/(1-exp(-x));};
 const std::function<double(double)> &nn::Sigmoid::getFunc() {return sig;}
+std::string nn::Sigmoid::getFuncId() {return "Sigmoid";}
 
 
 nn::Sigmoid::Sigmoid(double min, double max, uint32_t polyDeg)
@@ -0,0 +1,39 @@
+#include "NeuralOFHE/Operators/SlotLayout.h"
+#include <algorithm>
+
+
+nn::SlotLayout nn::SlotLayout::dense(uint32_t channels, uint32_t height, uint32_t width) {
+    return {channels, height, width, 1, width, height * width};
+}
+
+
+uint32_t nn::SlotLayout::slot(uint32_t c, uint32_t y, uint32_t x) const {
+    uint32_t block = c / (gap * gap);
+    uint32_t sub = c % (gap * gap);
+
+    return block * blockSize + (y * gap + sub / gap) * rowPitch + x * gap + sub % gap;
+}
+
+
+uint32_t nn::SlotLayout::size() const {
+    uint32_t last = 0;
+
+    //  The last channel does not necessarily occupy the last position of its block
+    for (uint32_t c = channels > gap * gap ? channels - gap * gap : 0; c < channels; c++)
+        last = std::max(last, slot(c, height - 1, width - 1));
+
+    return last + 1;
+}
+
+
+std::vector<uint32_t> nn::SlotLayout::slots() const {
+    std::vector<uint32_t> result;
+    result.reserve(channels * height * width);
+
+    for (uint32_t c = 0; c < channels; c++)
+        for (uint32_t y = 0; y < height; y++)
+            for (uint32_t x = 0; x < width; x++)
+                result.push_back(slot(c, y, x));
+
+    return result;
+}
@@ -0,0 +1,126 @@
+#include "NeuralOFHE/Tensor.h"
+
+#include <iostream>
+#include <numeric>
+#include <functional>
+
+
+/***
+ * Number of entries of a tensor with the given shape.
+ */
+static size_t shape_size(const std::vector<size_t>& shape) {
+    return std::accumulate(shape.begin(), shape.end(), (size_t) 1, std::multiplies<size_t>());
+}
+
+
+/***
+ * Shared pointer to the data of a vector that keeps the vector alive.
+ */
+static std::shared_ptr<const double> own(std::vector<double>&& values) {
+    auto owner = std::make_shared<std::vector<double>>(std::move(values));
+
+    return std::shared_ptr<const double>(owner, owner->data());
+}
+
+
+Tensor::Tensor() : dims{0}, stride(0) {
+
+}
+
+
+Tensor::Tensor(std::vector<size_t> shape) : Tensor(shape, std::vector<double>(shape_size(shape), .0)) {
+
+}
+
+
+Tensor::Tensor(std::vector<size_t> shape, std::vector<double>&& values) {
+    if (values.size() != shape_size(shape)) {
+        std::cerr << "Tensor has " << values.size() << " values, but its shape requires " << shape_size(shape) << "."
+                  << std::endl;
+        exit(1);
+    }
+
+    dims = std::move(shape);
+    stride = dims.empty() ? 1 : shape_size(dims) / std::max<size_t>(dims[0], 1);
+    storage = own(std::move(values));
+}
+
+
+Tensor::Tensor(std::vector<size_t> shape, std::shared_ptr<const double> data) {
+    dims = std::move(shape);
+    stride = dims.empty() ? 1 : shape_size(dims) / std::max<size_t>(dims[0], 1);
+    storage = std::move(data);
+}
+
+
+Tensor::Tensor(const matVec& matrix) {
+    size_t numCols = matrix.empty() ? 0 : matrix[0].size();
+    std::vector<double> values;
+    values.reserve(matrix.size() * numCols);
+
+    for (const auto& row : matrix) {
+        if (row.size() != numCols) {
+            std::cerr << "All rows of a matrix need the same size." << std::endl;
+            exit(1);
+        }
+
+        values.insert(values.end(), row.begin(), row.end());
+    }
+
+    dims = {matrix.size(), numCols};
+    stride = numCols;
+    storage = own(std::move(values));
+}
+
+
+const std::vector<size_t>& Tensor::shape() const {
+    return dims;
+}
+
+
+size_t Tensor::ndim() const {
+    return dims.size();
+}
+
+
+size_t Tensor::size() const {
+    return shape_size(dims);
+}
+
+
+bool Tensor::empty() const {
+    return size() == 0;
+}
+
+
+size_t Tensor::rows() const {
+    return dims.empty() ? 1 : dims[0];
+}
+
+
+size_t Tensor::cols() const {
+    return stride;
+}
+
+
+Tensor Tensor::transposed() const {
+    size_t numRows = rows();
+    size_t numCols = cols();
+    std::vector<double> values(numRows * numCols);
+
+    for (size_t i=0; i<numRows; i++)
+        for (size_t j=0; j<numCols; j++)
+            values[j * numRows + i] = (*this)(i, j);
+
+    return Tensor({numCols, numRows}, std::move(values));
+}
+
+
+matVec Tensor::toMatVec() const {
+    matVec result(rows());
+
+    for (size_t i=0; i<rows(); i++)
+        result[i].assign(row(i), row(i) + cols());
+
+    return result;
+}
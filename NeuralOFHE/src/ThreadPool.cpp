@@ -0,0 +1,114 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+
+/***
+ * Pool and queue index of the worker running on the current thread, nullptr for threads outside of any pool.
+ */
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local size_t currentIndex = 0;
+
+
+ThreadPool::ThreadPool(size_t threads) : pending(0), stopping(false) {
+    threads = std::max<size_t>(threads, 1);
+
+    for (size_t i = 0; i < threads; i++)
+        queues.push_back(std::make_unique<Queue>());
+
+    for (size_t i = 0; i < threads; i++)
+        workers.emplace_back(&ThreadPool::run, this, i);
+}
+
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+
+    wake.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+
+size_t ThreadPool::size() const {
+    return workers.size();
+}
+
+
+void ThreadPool::push(std::function<void()> task) {
+    Queue& queue = currentPool == this ? *queues[currentIndex] : shared;
+
+    {
+        std::lock_guard<std::mutex> sleepLock(sleepMutex);
+        std::lock_guard<std::mutex> queueLock(queue.mutex);
+
+        queue.tasks.push_back(std::move(task));
+        pending++;
+    }
+
+    wake.notify_one();
+}
+
+
+bool ThreadPool::pop(size_t index, std::function<void()>& task) {
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+
+        if (!queues[index]->tasks.empty()) {
+            task = std::move(queues[index]->tasks.back());
+            queues[index]->tasks.pop_back();
+            pending--;
+            return true;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(shared.mutex);
+
+        if (!shared.tasks.empty()) {
+            task = std::move(shared.tasks.front());
+            shared.tasks.pop_front();
+            pending--;
+            return true;
+        }
+    }
+
+    for (size_t offset = 1; offset < queues.size(); offset++) {
+        Queue& victim = *queues[(index + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            pending--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+void ThreadPool::run(size_t index) {
+    currentPool = this;
+    currentIndex = index;
+
+    while (true) {
+        std::function<void()> task;
+
+        if (pop(index, task)) {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this]() { return stopping || pending > 0; });
+
+        if (stopping && pending == 0)
+            return;
+    }
+}
@@ -0,0 +1,110 @@
+/**
+ * @file ThreadPool.h
+ *
+ * @brief Work-stealing thread pool that runs independent inference requests concurrently. Function bodies are defined
+ * in src/ThreadPool.cpp.
+ *
+ */
+
+#ifndef NEURALOFHE_THREADPOOL_H
+#define NEURALOFHE_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+/***
+ * Thread pool in which every worker owns a queue of tasks. Tasks submitted by a worker go to the back of its own queue,
+ * tasks from outside of the pool to a shared queue. Workers take tasks from the back of their own queue, then from the
+ * front of the shared queue and finally steal from the front of the queues of the others, so that long and short tasks
+ * even out. Tasks from outside are therefore started in the order of submission, so that under steady load old
+ * requests do not starve behind new ones.
+ *
+ * Tasks must not wait for tasks they submitted themselves, as all workers might be blocked by such tasks.
+ */
+class ThreadPool {
+public:
+    /***
+     * Constructor that starts the workers.
+     *
+     * @param threads Number of workers, at least one
+     */
+    explicit ThreadPool(size_t threads);
+
+    /***
+     * Destructor that finishes all submitted tasks and joins the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /***
+     * Submits a task to the pool.
+     *
+     * @param task Callable without arguments
+     * @return Future of the result of the task
+     */
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F&& task) {
+        using Result = std::invoke_result_t<F>;
+
+        //  std::function needs a copyable callable, the packaged task is therefore shared
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> future = packaged->get_future();
+
+        push([packaged]() { (*packaged)(); });
+
+        return future;
+    }
+
+    /***
+     * Getter for the number of workers.
+     *
+     * @return Number of workers
+     */
+    size_t size() const;
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void push(std::function<void()> task);
+
+    /***
+     * Takes a task from the back of the own queue, from the front of the shared queue or steals one from the front of
+     * another queue.
+     */
+    bool pop(size_t index, std::function<void()>& task);
+
+    void run(size_t index);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+
+    /***
+     * Tasks submitted from outside of the pool, in the order of submission.
+     */
+    Queue shared;
+    std::vector<std::thread> workers;
+
+    /***
+     * Number of tasks in all queues, guarded by sleepMutex for the workers to wait on.
+     */
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<size_t> pending;
+    bool stopping;
+};
+
+
+#endif //NEURALOFHE_THREADPOOL_H
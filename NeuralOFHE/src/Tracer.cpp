@@ -0,0 +1,260 @@
+#include "NeuralOFHE/Tracer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+/***
+ * Finished span, with times in microseconds since the start of the trace.
+ */
+struct TraceEvent {
+    const char* category;
+    std::string name;
+    int64_t index;
+    double start;
+    double duration;
+};
+
+
+/***
+ * Spans of one thread. Buffers stay alive after their thread has finished, so that they can still be written.
+ */
+struct TraceBuffer {
+    uint32_t tid;
+    std::string threadName;
+    std::vector<TraceEvent> events;
+};
+
+
+static std::atomic<bool> enabled(false);
+
+static std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+
+/***
+ * Incremented by every start, so that threads notice that their buffer belongs to an older trace.
+ */
+static std::atomic<uint64_t> generation(0);
+
+static std::mutex registryMutex;
+static std::vector<std::shared_ptr<TraceBuffer>> buffers;
+static std::map<std::string, LatencyHistogram> histograms;
+
+static thread_local std::shared_ptr<TraceBuffer> localBuffer;
+static thread_local uint64_t localGeneration = 0;
+
+
+static double now() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+}
+
+
+/***
+ * Buffer of the calling thread in the current trace, registered on first use.
+ */
+static TraceBuffer& buffer() {
+    uint64_t current = generation.load();
+
+    if (!localBuffer || localGeneration != current) {
+        localBuffer = std::make_shared<TraceBuffer>();
+        localGeneration = current;
+
+        std::ostringstream threadName;
+        #ifdef _OPENMP
+        if (omp_in_parallel())
+            threadName << "OpenMP thread " << omp_get_thread_num() << " (level " << omp_get_level() << ")";
+        else
+        #endif
+            threadName << "thread";
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        localBuffer->tid = buffers.size();
+        localBuffer->threadName = threadName.str() + " #" + std::to_string(localBuffer->tid);
+        buffers.push_back(localBuffer);
+    }
+
+    return *localBuffer;
+}
+
+
+void LatencyHistogram::add(double seconds) {
+    double micros = seconds * 1e6;
+    size_t bucket = micros < 2 ? 0 : (size_t) std::log2(micros);
+
+    if (buckets.size() <= bucket)
+        buckets.resize(bucket + 1, 0);
+    buckets[bucket]++;
+
+    minSeconds = count == 0 ? seconds : std::min(minSeconds, seconds);
+    maxSeconds = std::max(maxSeconds, seconds);
+    sumSeconds += seconds;
+    count++;
+}
+
+
+double LatencyHistogram::percentile(double p) const {
+    if (count == 0)
+        return 0;
+
+    uint64_t rank = (uint64_t) std::ceil(p / 100. * count);
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (seen >= std::max<uint64_t>(rank, 1))
+            return std::min(std::ldexp(1., i + 1) * 1e-6, maxSeconds);
+    }
+
+    return maxSeconds;
+}
+
+
+Tracer::Span::Span(const char* category, const std::string& name, int64_t index) {
+    if (!enabled.load(std::memory_order_relaxed))
+        return;
+
+    begin(category, name.c_str(), index);
+}
+
+
+Tracer::Span::Span(const char* category, const char* name, int64_t index) {
+    if (!enabled.load(std::memory_order_relaxed))
+        return;
+
+    begin(category, name, index);
+}
+
+
+void Tracer::Span::begin(const char* category, const char* name, int64_t index) {
+    this->active = true;
+    this->category = category;
+    this->name = name;
+    this->index = index;
+    this->start = now();
+}
+
+
+Tracer::Span::~Span() {
+    if (!active)
+        return;
+
+    double end = now();
+    buffer().events.push_back({category, std::move(name), index, start, end - start});
+}
+
+
+void Tracer::start() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    buffers.clear();
+    histograms.clear();
+    generation++;
+    enabled = true;
+}
+
+
+void Tracer::stop() {
+    enabled = false;
+}
+
+
+bool Tracer::isEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+
+/***
+ * Escapes a string for a JSON string literal.
+ */
+static std::string escape(const std::string& text) {
+    std::string result;
+
+    for (char c : text) {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        result += c;
+    }
+
+    return result;
+}
+
+
+void Tracer::write(const std::string& filePath) {
+    std::ofstream file(filePath);
+    if (!file.is_open()) {
+        std::cerr << "Error opening trace file at " << filePath << std::endl;
+        exit(1);
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+
+    for (const auto& threadBuffer : buffers) {
+        file << (first ? "" : ",") << "\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << threadBuffer->tid
+             << ",\"args\":{\"name\":\"" << escape(threadBuffer->threadName) << "\"}}";
+        first = false;
+
+        for (const auto& event : threadBuffer->events) {
+            file << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << threadBuffer->tid << ",\"cat\":\"" << event.category
+                 << "\",\"name\":\"" << escape(event.name) << "\",\"ts\":" << std::fixed << std::setprecision(3)
+                 << event.start << ",\"dur\":" << event.duration;
+
+            if (event.index >= 0)
+                file << ",\"args\":{\"index\":" << event.index << "}";
+
+            file << "}";
+        }
+    }
+
+    file << "\n]}\n";
+}
+
+
+void Tracer::recordLatency(const std::string& layerName, double seconds) {
+    if (!isEnabled())
+        return;
+
+    std::string type = layerName.substr(0, layerName.rfind('_'));
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    histograms[type].add(seconds);
+}
+
+
+std::map<std::string, LatencyHistogram> Tracer::getHistograms() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    return histograms;
+}
+
+
+std::string Tracer::histogramReport() {
+    std::ostringstream stream;
+
+    stream << std::left << std::setw(20) << "layer type" << std::right << std::setw(8) << "count" << std::setw(11)
+           << "mean [ms]" << std::setw(11) << "p50 [ms]" << std::setw(11) << "p90 [ms]" << std::setw(11) << "p99 [ms]"
+           << std::setw(11) << "max [ms]" << std::endl;
+
+    for (const auto& entry : getHistograms()) {
+        const LatencyHistogram& histogram = entry.second;
+
+        stream << std::left << std::setw(20) << entry.first << std::right << std::setw(8) << histogram.count
+               << std::fixed << std::setprecision(2) << std::setw(11) << 1e3 * histogram.sumSeconds / histogram.count
+               << std::setw(11) << 1e3 * histogram.percentile(50) << std::setw(11) << 1e3 * histogram.percentile(90)
+               << std::setw(11) << 1e3 * histogram.percentile(99) << std::setw(11) << 1e3 * histogram.maxSeconds
+               << std::endl;
+    }
+
+    return stream.str();
+}
@@ -0,0 +1,58 @@
+import asyncio
+import neuralpy
+import numpy as np
+from os import listdir
+from time import time
+
+
+async def main() -> None:
+    # Load the context and keys generated by keygen.py
+    context = neuralpy.Context()
+    keypair = neuralpy.KeyPair()
+
+    context.load("keys/context")
+    context.loadMultKeys("keys/multKeys")
+    context.loadRotKeys("keys/rotKeys")
+
+    keypair.publicKey.load("keys/publicKey")
+    keypair.privateKey.load("keys/privateKey")
+
+    neuralpy.SetContext(context)
+
+    conv_weights, conv_biases = np.load("model/_Conv_0_weights.npy"), np.load("model/_Conv_0_bias.npy")
+    gemm0_weights, gemm0_biases = np.load("model/_Gemm_3_w.npy"), np.load("model/_Gemm_3_bias.npy")
+    gemm1_weights, gemm1_biases = np.load("model/_Gemm_5_w.npy"), np.load("model/_Gemm_5_bias.npy")
+
+    operations = [
+        neuralpy.Conv2D(conv_weights, conv_biases),
+        neuralpy.ReLU(-6.5318193435668945, 8.548895835876465, 3),
+        neuralpy.Gemm(gemm0_weights, gemm0_biases),
+        neuralpy.ReLU(-14.685586750507355, 12.968225657939911, 3),
+        neuralpy.Gemm(gemm1_weights, gemm1_biases),
+    ]
+
+    filenames = sorted(listdir("images"))[:64]
+    inputs = [context.Encrypt(list(np.load("images/" + f)[0][0].flat), keypair.publicKey) for f in filenames]
+
+    # At most four forward passes run at once, the others wait in the queue of the executor
+    executor = neuralpy.AsyncExecutor(4)
+
+    start = time()
+    requests = [executor.ForwardModel(operations, x) for x in inputs]
+
+    # Requests can be cancelled as long as their forward pass has not started
+    requests[-1].cancel()
+
+    outputs = await asyncio.gather(*requests, return_exceptions=True)
+    elapsed = time() - start
+
+    finished = [output for output in outputs if not isinstance(output, asyncio.CancelledError)]
+    print("{} requests finished, {} cancelled, {:.2f} req/s".format(
+        len(finished), len(outputs) - len(finished), len(finished) / elapsed))
+
+    predictions = [int(np.argmax(context.Decrypt(output, keypair.privateKey))) for output in finished[:10]]
+    print("Predictions of the first requests: {}".format(predictions))
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -3,7 +3,6 @@ import numpy as np
 from os import listdir
 from random import choice 
 import matplotlib.pyplot as plt
-from time import time
 import json
 
 
@@ -54,19 +53,15 @@ def main() -> None:
         neuralpy.Gemm(gemm1_weights, gemm1_biases),
     ]
 
-    total_time = 0
+    # Record time and HE operations of every layer
+    neuralpy.SetProfiling(True)
 
     # Carrying out operations
     for operation in operations:
-        print("Beginning calculation of {}".format(operation.GetName()))
-        start = time()
         x = operation(x)
-        end = time()
 
-        elapsed = end - start
-        total_time += elapsed
-
-        print("Took {}s".format(elapsed))
+    print(neuralpy.ProfileReport(operations))
+    total_time = sum(operation.GetProfile().seconds for operation in operations)
 
 
     # Decrypt image
@@ -1 +1,221 @@
-#include 
\ No newline at end of file
+/**
+ * @file inference.cpp
+ *
+ * @brief End-to-end inference of the model of cryptonet_inference.py without Python. Loads the context and keys that
+ * keygen.py wrote to keys/ and maps the weights in model/ into memory, see LoadNpy. Every image in images/ is
+ * encrypted, run through the model and decrypted, with several requests in flight at once. Reports the latency
+ * percentiles of a request, from encryption to decryption, the throughput, the peak resident memory and how often the
+ * encrypted model predicts the same class as the plaintext model.
+ *
+ * Usage, from within example_code: NeuralOFHE_inference [concurrency] [cores] [images]
+ *  - concurrency: Number of requests in flight, 1 by default
+ *  - cores: Number of cores shared by the requests, the number of OpenMP threads if 0 or not given
+ *  - images: Number of images to run, all of them if 0 or not given
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+#include <sys/resource.h>
+
+#include "NeuralOFHE/NeuralOFHE.h"
+
+#include "key/key-ser.h"
+#include "scheme/ckksrns/ckksrns-ser.h"
+#include "cryptocontext-ser.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+/***
+ * Copies the entries of a tensor into a vector, e.g. for a bias.
+ */
+static std::vector<double> to_vector(const Tensor& tensor) {
+    return std::vector<double>(tensor.data(), tensor.data() + tensor.size());
+}
+
+
+/***
+ * Affine layer x @ weights + bias of the plaintext model, optionally followed by a ReLU.
+ */
+static std::vector<double> plain_dense(const std::vector<double>& x, const Tensor& weights, const Tensor& bias,
+                                       bool relu) {
+    std::vector<double> y = to_vector(bias);
+    for (size_t i = 0; i < weights.rows(); i++)
+        for (size_t j = 0; j < weights.cols(); j++)
+            y[j] += x[i] * weights(i, j);
+
+    if (relu)
+        for (auto& entry : y)
+            entry = std::max(entry, .0);
+
+    return y;
+}
+
+
+/***
+ * Percentile of sorted latencies by the nearest rank method.
+ */
+static double percentile(const std::vector<double>& sorted, double p) {
+    size_t rank = (size_t) std::ceil(p / 100. * sorted.size());
+    return sorted[std::min(std::max(rank, (size_t) 1), sorted.size()) - 1];
+}
+
+
+int main(int argc, char* argv[]) {
+    uint32_t concurrency = argc > 1 ? std::max(std::stoul(argv[1]), 1ul) : 1;
+    uint32_t cores = argc > 2 ? std::stoul(argv[2]) : 0;
+    size_t limit = argc > 3 ? std::stoul(argv[3]) : 0;
+
+    #ifdef _OPENMP
+    if (cores == 0)
+        cores = omp_get_max_threads();
+    #endif
+    cores = std::max(cores, 1u);
+
+    //  Context and keys as written by keygen.py
+    CryptoContext<DCRTPoly> context;
+    if (!Serial::DeserializeFromFile("keys/context", context, SerType::BINARY)) {
+        std::cerr << "Error loading context, run keygen.py first" << std::endl;
+        exit(1);
+    }
+
+    context->ClearEvalMultKeys();
+    std::ifstream multKeys("keys/multKeys", std::ios::in | std::ios::binary);
+    if (!multKeys.is_open() || !context->DeserializeEvalMultKey(multKeys, SerType::BINARY)) {
+        std::cerr << "Error loading mult. key." << std::endl;
+        exit(1);
+    }
+
+    context->ClearEvalAutomorphismKeys();
+    std::ifstream rotKeys("keys/rotKeys", std::ios::in | std::ios::binary);
+    if (!rotKeys.is_open() || !context->DeserializeEvalAutomorphismKey(rotKeys, SerType::BINARY)) {
+        std::cerr << "Error loading rot. key." << std::endl;
+        exit(1);
+    }
+
+    KeyPair<DCRTPoly> keys;
+    if (!Serial::DeserializeFromFile("keys/publicKey", keys.publicKey, SerType::BINARY) ||
+        !Serial::DeserializeFromFile("keys/privateKey", keys.secretKey, SerType::BINARY)) {
+        std::cerr << "Error loading key pair." << std::endl;
+        exit(1);
+    }
+
+    SetContext(context);
+
+    Tensor convWeights = LoadNpy("model/_Conv_0_weights.npy"), convBias = LoadNpy("model/_Conv_0_bias.npy");
+    Tensor gemm0Weights = LoadNpy("model/_Gemm_3_w.npy"), gemm0Bias = LoadNpy("model/_Gemm_3_bias.npy");
+    Tensor gemm1Weights = LoadNpy("model/_Gemm_5_w.npy"), gemm1Bias = LoadNpy("model/_Gemm_5_bias.npy");
+
+    Application app({
+            std::make_shared<nn::Conv2D>(convWeights, to_vector(convBias)),
+            std::make_shared<nn::ReLU>(-6.5318193435668945, 8.548895835876465, 3),
+            std::make_shared<nn::Gemm>(gemm0Weights, to_vector(gemm0Bias)),
+            std::make_shared<nn::ReLU>(-14.685586750507355, 12.968225657939911, 3),
+            std::make_shared<nn::Gemm>(gemm1Weights, to_vector(gemm1Bias))
+    });
+
+    //  Images are read up front, so that disk accesses are not part of the latencies
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::directory_iterator("images"))
+        if (entry.path().extension() == ".npy")
+            files.push_back(entry.path());
+    std::sort(files.begin(), files.end());
+
+    if (limit != 0 && limit < files.size())
+        files.resize(limit);
+
+    if (files.empty()) {
+        std::cerr << "No images found in images/" << std::endl;
+        exit(1);
+    }
+
+    std::vector<std::vector<double>> images;
+    for (const auto& file : files)
+        images.push_back(to_vector(LoadNpy(file.string())));
+
+    size_t outputs = gemm1Bias.size();
+    std::vector<double> latencies(images.size());
+    std::vector<std::vector<double>> results(images.size());
+    std::atomic<size_t> next(0);
+
+    //  As in Application::forwardBatch the cores are split between the requests and the OpenMP loops within them
+    concurrency = std::min<size_t>(concurrency, images.size());
+    uint32_t threadsPerRequest = std::max(cores / concurrency, 1u);
+
+    auto worker = [&]() {
+        #ifdef _OPENMP
+        omp_set_num_threads(threadsPerRequest);
+        #endif
+
+        for (size_t i = next++; i < images.size(); i = next++) {
+            auto start = std::chrono::steady_clock::now();
+
+            auto x = context->Encrypt(keys.publicKey, context->MakeCKKSPackedPlaintext(images[i]));
+            x = app.forward(x);
+
+            Plaintext result;
+            context->Decrypt(keys.secretKey, x, &result);
+            result->SetLength(outputs);
+            results[i] = result->GetRealPackedValue();
+
+            latencies[i] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    };
+
+    std::cout << images.size() << " images, " << concurrency << " in flight on " << cores << " cores" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 1; i < concurrency; i++)
+        workers.emplace_back(worker);
+    worker();
+    for (auto& thread : workers)
+        thread.join();
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    //  Agreement of the predicted classes and the largest deviation of the outputs from the plaintext model
+    size_t agreements = 0;
+    double maxError = 0;
+    for (size_t i = 0; i < images.size(); i++) {
+        auto plain = plain_dense(images[i], convWeights, convBias, true);
+        plain = plain_dense(plain, gemm0Weights, gemm0Bias, true);
+        plain = plain_dense(plain, gemm1Weights, gemm1Bias, false);
+
+        if (std::max_element(plain.begin(), plain.end()) - plain.begin() ==
+            std::max_element(results[i].begin(), results[i].end()) - results[i].begin())
+            agreements++;
+
+        for (size_t j = 0; j < outputs; j++)
+            maxError = std::max(maxError, std::abs(plain[j] - results[i][j]));
+    }
+
+    std::vector<double> sorted = latencies;
+    std::sort(sorted.begin(), sorted.end());
+
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "latency p50: " << percentile(sorted, 50) << " s, p90: " << percentile(sorted, 90) << " s, p99: "
+              << percentile(sorted, 99) << " s, max: " << sorted.back() << " s" << std::endl;
+    std::cout << "throughput: " << images.size() / elapsed << " images/s (" << elapsed << " s total)" << std::endl;
+    //  ru_maxrss is in kilobytes on Linux
+    std::cout << "peak RSS: " << usage.ru_maxrss / 1024. << " MiB" << std::endl;
+    std::cout << "agreement with the plaintext model: " << agreements << "/" << images.size() << " ("
+              << 100. * agreements / images.size() << "%), max. output error " << maxError << std::endl;
+
+    return 0;
+}
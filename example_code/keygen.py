@@ -1,4 +1,5 @@
 import neuralpy
+import numpy as np
 
 
 def main() -> None:
@@ -29,8 +30,21 @@ def main() -> None:
     context.EvalMultKeyGen(keypair.privateKey)
     print("Done!")
 
+    # Only the rotations used by the linear layers of the model need keys. The activations do not rotate
+    neuralpy.SetContext(context)
+
+    conv_weights, conv_biases = np.load("model/_Conv_0_weights.npy"), np.load("model/_Conv_0_bias.npy")
+    gemm0_weights, gemm0_biases = np.load("model/_Gemm_3_w.npy"), np.load("model/_Gemm_3_bias.npy")
+    gemm1_weights, gemm1_biases = np.load("model/_Gemm_5_w.npy"), np.load("model/_Gemm_5_bias.npy")
+
+    operations = [
+        neuralpy.Conv2D(conv_weights, conv_biases),
+        neuralpy.Gemm(gemm0_weights, gemm0_biases),
+        neuralpy.Gemm(gemm1_weights, gemm1_biases),
+    ]
+
     print("Generating rotation keys...")
-    context.GenRotateKeys(keypair.privateKey)
+    context.GenRotateKeys(keypair.privateKey, operations)
     print("Done!")
 
     # Saving keys to file
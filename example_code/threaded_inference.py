@@ -0,0 +1,75 @@
+import neuralpy
+import numpy as np
+from concurrent.futures import ThreadPoolExecutor
+from os import cpu_count, listdir
+from time import time
+
+
+def main() -> None:
+    # Load the context and keys generated by keygen.py
+    context = neuralpy.Context()
+    keypair = neuralpy.KeyPair()
+
+    context.load("keys/context")
+    context.loadMultKeys("keys/multKeys")
+    context.loadRotKeys("keys/rotKeys")
+
+    keypair.publicKey.load("keys/publicKey")
+    keypair.privateKey.load("keys/privateKey")
+
+    neuralpy.SetContext(context)
+
+    conv_weights, conv_biases = np.load("model/_Conv_0_weights.npy"), np.load("model/_Conv_0_bias.npy")
+    gemm0_weights, gemm0_biases = np.load("model/_Gemm_3_w.npy"), np.load("model/_Gemm_3_bias.npy")
+    gemm1_weights, gemm1_biases = np.load("model/_Gemm_5_w.npy"), np.load("model/_Gemm_5_bias.npy")
+
+    # The operators are shared by all threads
+    operations = [
+        neuralpy.Conv2D(conv_weights, conv_biases),
+        neuralpy.ReLU(-6.5318193435668945, 8.548895835876465, 3),
+        neuralpy.Gemm(gemm0_weights, gemm0_biases),
+        neuralpy.ReLU(-14.685586750507355, 12.968225657939911, 3),
+        neuralpy.Gemm(gemm1_weights, gemm1_biases),
+    ]
+
+    images = [np.load("images/" + filename)[0][0] for filename in sorted(listdir("images"))[:16]]
+    inputs = [context.Encrypt(list(image.flat), keypair.publicKey) for image in images]
+
+    def infer(x):
+        for operation in operations:
+            x = operation(x)
+        return x
+
+    # Warm-up pass, which fills the plaintext caches of the operators
+    infer(inputs[0])
+
+    cores = cpu_count()
+    baseline = None
+
+    print("{:>8} {:>10} {:>10}".format("threads", "req/s", "speedup"))
+
+    threads = 1
+    while threads <= cores:
+        # Every Python thread runs its operators with an equal share of the OpenMP threads
+        executor = ThreadPoolExecutor(threads, initializer=neuralpy.SetNumThreads, initargs=(max(1, cores // threads),))
+
+        start = time()
+        outputs = list(executor.map(infer, inputs))
+        elapsed = time() - start
+        executor.shutdown()
+
+        throughput = len(inputs) / elapsed
+        baseline = baseline or throughput
+
+        print("{:>8} {:>10.2f} {:>10.2f}".format(threads, throughput, throughput / baseline))
+
+        threads = cores if threads * 2 > cores and threads != cores else threads * 2
+
+    # The outputs of the concurrent passes have to match those of a sequential one
+    expected = np.array(context.Decrypt(infer(inputs[-1]), keypair.privateKey))
+    result = np.array(context.Decrypt(outputs[-1], keypair.privateKey))
+    print("Max. deviation from the sequential pass: {}".format(np.max(np.abs(expected - result))))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,218 @@
+/**
+ * @file AsyncExecutor.h
+ *
+ * @brief Executor that runs forward passes on a C++ thread pool and reports their results through Python futures, so
+ * that an asyncio event loop can keep many encrypted requests in flight without blocking.
+ *
+ */
+
+#ifndef NEURALPY_ASYNCEXECUTOR_H
+#define NEURALPY_ASYNCEXECUTOR_H
+
+#include <pybind11/pybind11.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "WrapperClasses.h"
+#include "../../NeuralOFHE/src/ThreadPool.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+/***
+ * Runs forward passes of operators or whole models asynchronously.
+ *
+ * Every submission returns a concurrent.futures.Future, which is completed from a worker thread of the pool. The
+ * awaitable variants wrap it into an asyncio future of the running event loop. Cancelling either future before the
+ * evaluation has started skips it, an evaluation that already runs is finished.
+ *
+ * At most maxInFlight evaluations run at once, one per worker, which bounds the memory of the intermediate
+ * ciphertexts. Further submissions wait in the queue of the pool, holding only their input ciphertext, and are started
+ * in the order of submission.
+ */
+class AsyncExecutor {
+public:
+    /***
+     * Constructor that starts the workers.
+     *
+     * @param maxInFlight Maximum number of concurrent evaluations, the number of OpenMP threads if 0
+     * @param threads Number of OpenMP threads of every evaluation, the cores divided by maxInFlight if 0
+     */
+    explicit AsyncExecutor(uint32_t maxInFlight = 0, uint32_t threads = 0) {
+        #ifdef _OPENMP
+        uint32_t cores = omp_get_max_threads();
+        #else
+        uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+        #endif
+
+        if (maxInFlight == 0)
+            maxInFlight = cores;
+
+        this->threads = threads != 0 ? threads : std::max(1u, cores / maxInFlight);
+        pool = std::make_unique<ThreadPool>(maxInFlight);
+    }
+
+    /***
+     * Destructor that cancels all evaluations that have not started yet and waits for the running ones. Must be
+     * called with the GIL held, which is released while waiting, as the workers need it to complete their futures.
+     */
+    ~AsyncExecutor() {
+        stopping = true;
+
+        pybind11::gil_scoped_release release;
+        pool.reset();
+    }
+
+    /***
+     * Submits the forward pass of a single operator.
+     *
+     * @param op Operator, which the binding keeps alive as long as the returned future
+     * @param x Input ciphertext
+     * @return concurrent.futures.Future of the output ciphertext
+     */
+    pybind11::object submit(Operator* op, PythonCiphertext x) {
+        return submitModel({op}, x);
+    }
+
+    /***
+     * Submits the forward pass of a model, i.e. the forward passes of its operators one after another.
+     *
+     * @param operators Operators in order, which the binding keeps alive as long as the returned future
+     * @param x Input ciphertext
+     * @return concurrent.futures.Future of the output ciphertext
+     */
+    pybind11::object submitModel(std::vector<Operator*> operators, PythonCiphertext x) {
+        pybind11::object future = pybind11::module_::import("concurrent.futures").attr("Future")();
+
+        //  The future is referenced from the worker, which has to hold the GIL when releasing it
+        std::shared_ptr<pybind11::object> handle(new pybind11::object(future), [](pybind11::object* object) {
+            pybind11::gil_scoped_acquire gil;
+            delete object;
+        });
+
+        Ciphertext<DCRTPoly> input = x.getCiphertext();
+        pending++;
+
+        pool->submit([this, handle, operators, input]() {
+            //  Decrements the pending evaluations however run returns
+            struct PendingGuard {
+                std::atomic<size_t>& pending;
+                ~PendingGuard() { pending--; }
+            } guard{pending};
+
+            run(*handle, operators, input);
+        });
+
+        return future;
+    }
+
+    /***
+     * Awaitable variant of submit, to be called from a running asyncio event loop.
+     *
+     * @param op Operator, which the binding keeps alive as long as the returned future
+     * @param x Input ciphertext
+     * @return asyncio future of the output ciphertext
+     */
+    pybind11::object forward(Operator* op, PythonCiphertext x) {
+        return pybind11::module_::import("asyncio").attr("wrap_future")(submit(op, x));
+    }
+
+    /***
+     * Awaitable variant of submitModel, to be called from a running asyncio event loop.
+     *
+     * @param operators Operators in order, which the binding keeps alive as long as the returned future
+     * @param x Input ciphertext
+     * @return asyncio future of the output ciphertext
+     */
+    pybind11::object forwardModel(std::vector<Operator*> operators, PythonCiphertext x) {
+        return pybind11::module_::import("asyncio").attr("wrap_future")(submitModel(std::move(operators), x));
+    }
+
+    /***
+     * Getter for the number of submitted evaluations that have not been completed yet, running or waiting.
+     *
+     * @return Number of pending evaluations
+     */
+    size_t getPending() const {
+        return pending;
+    }
+
+    /***
+     * Getter for the maximum number of concurrent evaluations.
+     *
+     * @return Number of workers
+     */
+    size_t getMaxInFlight() const {
+        return pool->size();
+    }
+
+private:
+    /***
+     * Evaluates the operators on a worker and completes the future, unless it was cancelled before.
+     */
+    void run(const pybind11::object& future, const std::vector<Operator*>& operators, Ciphertext<DCRTPoly> x) {
+        {
+            pybind11::gil_scoped_acquire gil;
+
+            if (stopping) {
+                future.attr("cancel")();
+                return;
+            }
+
+            if (!future.attr("set_running_or_notify_cancel")().cast<bool>())
+                return;
+        }
+
+        //  The number of threads is an ICV of the worker, so it only limits the regions of this evaluation
+        #ifdef _OPENMP
+        omp_set_num_threads(threads);
+        #endif
+
+        //  Every exception has to complete the future, otherwise awaiting it would never return
+        bool failed = false;
+        std::string error;
+        try {
+            auto lock = PythonContext::readKeys();
+
+            for (Operator* op : operators)
+                x = op->evaluate(x);
+        } catch (pybind11::error_already_set& pythonError) {
+            //  Raised by operators whose forward is overridden in Python
+            pybind11::gil_scoped_acquire gil;
+            future.attr("set_exception")(pythonError.value());
+            return;
+        } catch (const std::exception& exception) {
+            //  E.g. an OpenFHEException for a missing rotation key or an exhausted depth
+            failed = true;
+            error = exception.what();
+        } catch (...) {
+            failed = true;
+            error = "Unknown error during the evaluation";
+        }
+
+        if (failed) {
+            pybind11::gil_scoped_acquire gil;
+            future.attr("set_exception")(pybind11::module_::import("builtins").attr("RuntimeError")(error));
+            return;
+        }
+
+        PythonCiphertext result;
+        result.setCiphertext(x);
+
+        pybind11::gil_scoped_acquire gil;
+        future.attr("set_result")(result);
+    }
+
+    std::unique_ptr<ThreadPool> pool;
+    uint32_t threads;
+
+    std::atomic<size_t> pending{0};
+    std::atomic<bool> stopping{false};
+};
+
+
+#endif //NEURALPY_ASYNCEXECUTOR_H
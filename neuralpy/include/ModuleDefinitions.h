@@ -9,12 +9,14 @@
 
 #include "../include/WrapperClasses.h"
 #include "WrapperFunctions.h"
+#include "AsyncExecutor.h"
 
 namespace py = pybind11;
 
 
 /***
- * Returns the forward function as a C++ lambda in order to reduce boilerplate code.
+ * Returns the forward function as a C++ lambda in order to reduce boilerplate code. The GIL is released during the
+ * forward pass, so that Python threads can run several of them at once, and the evaluation keys are locked shared.
  *
  * @tparam T Class of the Operation
  * @return Lambda applying the forward function to an input.
@@ -25,13 +27,24 @@ std::function<PythonCiphertext (T&, PythonCiphertext)> initForward() {
             Ciphertext<DCRTPoly> input = x.getCiphertext();
             PythonCiphertext result;
 
-            result.setCiphertext(self.forward(input));
+            {
+                py::gil_scoped_release release;
+                auto lock = PythonContext::readKeys();
+
+                result.setCiphertext(self.evaluate(input));
+            }
 
             return result;
     };
 }
 
 
+/***
+ * Call guard of the bindings that run long enough in C++ to release the GIL for them.
+ */
+using ReleaseGIL = py::call_guard<py::gil_scoped_release>;
+
+
 /***
  * Defines all enums, OpenFHE uses for setting CKKS parameters.
  */
@@ -109,8 +122,8 @@ void defineBasicOpenFHEModules (py::module_& m) {
 
     py::class_<PythonCiphertext>(m, "Ciphertext")
             .def(py::init<>())
-            .def("save", &PythonCiphertext::save, py::arg("filePath"))
-            .def("load", &PythonCiphertext::load, py::arg("filePath"))
+            .def("save", &PythonCiphertext::save, py::arg("filePath"), ReleaseGIL())
+            .def("load", &PythonCiphertext::load, py::arg("filePath"), ReleaseGIL())
             .def("GetLevel", &PythonCiphertext::GetLevel);
 
     py::class_<PythonContext>(m, "Context")
@@ -119,86 +132,91 @@ void defineBasicOpenFHEModules (py::module_& m) {
                  "Enable an OpenFHE feature.",
                  py::arg("feature"))
             .def("KeyGen", &PythonContext::KeyGen,
-                 "Generate keypair.")
+                 "Generate keypair.", ReleaseGIL())
             .def("GetRingDimension", &PythonContext::GetRingDim,
                  "Getter function for the ring dimension.")
             .def("Encrypt", &PythonContext::Encrypt,
                  "Encrypt an OpenFHE plaintext.",
                  py::arg("plaintext"),
-                 py::arg("publicKey"))
+                 py::arg("publicKey"), ReleaseGIL())
             .def("Decrypt", &PythonContext::Decrypt,
                  "Decrypt a ciphertext into an OpenFHE plaintext.",
                  py::arg("ciphertext"),
-                 py::arg("privateKey"))
+                 py::arg("privateKey"), ReleaseGIL())
             .def("EvalMultKeyGen", &PythonContext::EvalMultKeyGen,
-                 py::arg("privateKey"))
+                 py::arg("privateKey"), ReleaseGIL())
             .def("EvalBootstrapKeyGen", &PythonContext::EvalBootstrapKeyGen,
-                 py::arg("privateKey"))
+                 py::arg("privateKey"), ReleaseGIL())
             .def("EvalBootstrap", &PythonContext::EvalBootstrap,
-                 py::arg("cipher"))
-            .def("GenRotateKeys", &PythonContext::GenRotations,
-                 "Generate rotation keys for doing matrix multiplication with the given batch size.")
+                 py::arg("cipher"), ReleaseGIL())
+            .def("GenRotateKeys", py::overload_cast<PythonKey<PrivateKey<DCRTPoly>>>(&PythonContext::GenRotations),
+                 "Generate rotation keys for doing matrix multiplication with the given batch size.",
+                 py::arg("privateKey"), ReleaseGIL())
+            .def("GenRotateKeys",
+                 py::overload_cast<PythonKey<PrivateKey<DCRTPoly>>, const std::vector<Operator*>&>(&PythonContext::GenRotations),
+                 "Generate only the rotation keys that the given operators use.",
+                 py::arg("privateKey"), py::arg("operators"), ReleaseGIL())
             .def("save", &PythonContext::save,
                  "Serialize the context to a file.",
-                 py::arg("filePath"))
+                 py::arg("filePath"), ReleaseGIL())
             .def("load", &PythonContext::load,
                  "Deserialize the context from a file.",
-                 py::arg("filePath"))
+                 py::arg("filePath"), ReleaseGIL())
             .def("saveMultKeys", &PythonContext::saveMultKeys,
                  "Serialize the multiplication keys to a file.",
-                 py::arg("filePath"))
+                 py::arg("filePath"), ReleaseGIL())
             .def("loadMultKeys", &PythonContext::loadMultKeys,
                  "Load multiplication keys from a file to the context object.",
-                 py::arg("filePath"))
+                 py::arg("filePath"), ReleaseGIL())
             .def("saveRotKeys", &PythonContext::saveRotKeys,
                  "Save rotation keys to a file.",
-                 py::arg("filePath"))
+                 py::arg("filePath"), ReleaseGIL())
             .def("loadRotKeys", &PythonContext::loadRotKeys,
                  "Read rotation keys from a file into the context object.",
-                 py::arg("filePath"))
+                 py::arg("filePath"), ReleaseGIL())
             .def("EvalAdd", py::overload_cast<PythonCiphertext, PythonCiphertext>(&PythonContext::EvalAdd),
                     "Addition of two ciphertexts a and b.",
                     py::arg("a"),
-                    py::arg("b"))
+                    py::arg("b"), ReleaseGIL())
             .def("EvalAdd", py::overload_cast<std::vector<double>, PythonCiphertext>(&PythonContext::EvalAdd),
                     "Addition of a plaintext a with a ciphertext b",
                     py::arg("a"),
-                    py::arg("b"))
+                    py::arg("b"), ReleaseGIL())
             .def("EvalAdd", py::overload_cast<double, PythonCiphertext>(&PythonContext::EvalAdd),
                     "Addition of a floating point number a with a ciphertext b",
                     py::arg("a"),
-                    py::arg("b"))
+                    py::arg("b"), ReleaseGIL())
             .def("EvalMult", py::overload_cast<PythonCiphertext, PythonCiphertext>(&PythonContext::EvalMult),
                     "Multiplication of two ciphertexts.",
                     py::arg("a"),
-                    py::arg("b"))
+                    py::arg("b"), ReleaseGIL())
             .def("EvalMult", py::overload_cast<std::vector<double>, PythonCiphertext>(&PythonContext::EvalMult),
                     "Multiplication of a plaintext a with a ciphertext b",
                     py::arg("a"),
-                    py::arg("b"))
+                    py::arg("b"), ReleaseGIL())
             .def("EvalMult", py::overload_cast<double, PythonCiphertext>(&PythonContext::EvalMult),
                     "Multiplication of a floating point number a with a ciphertext b",
                     py::arg("a"),
-                    py::arg("b"))
+                    py::arg("b"), ReleaseGIL())
             .def("EvalSub", py::overload_cast<PythonCiphertext, PythonCiphertext>(&PythonContext::EvalSub),
                     "Subtraction of ciphertext b from ciphertext a.",
                     py::arg("a"),
-                    py::arg("b"))
+                    py::arg("b"), ReleaseGIL())
             .def("EvalSub", py::overload_cast<std::vector<double>, PythonCiphertext, bool>(&PythonContext::EvalSub),
                     "Subtraction of ciphertext b from plaintext a, dependant on the reverse variable.",
                     py::arg("a"),
                     py::arg("b"),
-                    py::arg("reverse")=false)
+                    py::arg("reverse")=false, ReleaseGIL())
             .def("EvalSub", py::overload_cast<double, PythonCiphertext, bool>(&PythonContext::EvalSub),
                     "Subtraction of ciphertext b from floating point number a, dependant on the reverse variable.",
                     py::arg("a"),
                     py::arg("b"),
-                    py::arg("reverse")=false)
+                    py::arg("reverse")=false, ReleaseGIL())
             .def("EvalMatMul", &PythonContext::EvalMatMul, py::arg("matrix"),
                  py::arg("ciphertext"),
-                 py::arg("parallel") = true)
-            .def("hasRelinKeys", &PythonContext::hasRelinKeys)
-            .def("hasGaloisKeys", &PythonContext::hasGaloisKeys)
+                 py::arg("parallel") = true, ReleaseGIL())
+            .def("hasRelinKeys", &PythonContext::hasRelinKeys, ReleaseGIL())
+            .def("hasGaloisKeys", &PythonContext::hasGaloisKeys, ReleaseGIL())
             .def("getModulus", &PythonContext::getModulus);
 }
 
@@ -207,24 +225,126 @@ void defineBasicOpenFHEModules (py::module_& m) {
  * Defines wrappers around the NeuralOFHE classes
  */
 void defineNeuralOFHETypes (py::module_& m) {
+    py::class_<Tensor>(m, "Tensor", py::buffer_protocol())
+            .def(py::init(&TensorFromArray), py::arg("array"),
+                 "Wrap a numpy array of doubles without copying it. Other arrays are converted first.")
+            .def_buffer(&TensorBuffer)
+            .def_property_readonly("shape", &Tensor::shape);
+
+    //  Operators taking a tensor accept numpy arrays and nested lists directly
+    py::implicitly_convertible<py::array, Tensor>();
+    py::implicitly_convertible<py::list, Tensor>();
+
+    py::class_<LayerProfile>(m, "LayerProfile")
+            .def_readonly("name", &LayerProfile::name)
+            .def_readonly("calls", &LayerProfile::calls)
+            .def_readonly("seconds", &LayerProfile::seconds)
+            .def_readonly("fastRotations", &LayerProfile::fastRotations)
+            .def_readonly("rotations", &LayerProfile::rotations)
+            .def_readonly("plainMults", &LayerProfile::plainMults)
+            .def_readonly("cipherMults", &LayerProfile::cipherMults)
+            .def_readonly("scalarMults", &LayerProfile::scalarMults)
+            .def_readonly("rescales", &LayerProfile::rescales)
+            .def_readonly("encodes", &LayerProfile::encodes)
+            .def_readonly("keySwitches", &LayerProfile::keySwitches)
+            .def_readonly("bootstraps", &LayerProfile::bootstraps)
+            .def_readonly("inputLevel", &LayerProfile::inputLevel)
+            .def_readonly("outputLevel", &LayerProfile::outputLevel)
+            .def_readonly("inputBytes", &LayerProfile::inputBytes)
+            .def_readonly("outputBytes", &LayerProfile::outputBytes)
+            .def("ToDict", &LayerProfileToDict,
+                 "All fields of the profile as a dictionary, e.g. for logging it as JSON.");
+
     py::class_<Operator, PythonOperator>(m, "Operator")
             .def(py::init<uint32_t&, std::string>())
-            .def("GetName", &Operator::getName);
+            .def("GetName", &Operator::getName)
+            .def("SetCacheBudget", &Operator::setCacheBudget,
+                 "Set the memory budget of the operators plaintext cache in bytes.",
+                 py::arg("bytes"))
+            .def("WarmUp", &Operator::warmUp,
+                 "Encode all plaintexts of the operator for ciphertexts on the given level.",
+                 py::arg("level"))
+            .def("GetRotationIndices", &Operator::getRotationIndices,
+                 "Rotation indices the forward pass of the operator requests.")
+            .def("GetDepth", &Operator::getDepth,
+                 "Number of multiplicative levels the forward pass of the operator consumes.")
+            .def("GetProfile", &Operator::getProfile,
+                 "Profile of the forward passes since the last reset, recorded while profiling is enabled.")
+            .def("ResetProfile", &Operator::resetProfile);
+
+    py::class_<nn::SlotLayout>(m, "SlotLayout")
+            .def_static("Dense", &nn::SlotLayout::dense,
+                        py::arg("channels"), py::arg("height"), py::arg("width"))
+            .def_readwrite("channels", &nn::SlotLayout::channels)
+            .def_readwrite("height", &nn::SlotLayout::height)
+            .def_readwrite("width", &nn::SlotLayout::width)
+            .def_readwrite("gap", &nn::SlotLayout::gap)
+            .def_readwrite("rowPitch", &nn::SlotLayout::rowPitch)
+            .def_readwrite("blockSize", &nn::SlotLayout::blockSize)
+            .def("Slot", &nn::SlotLayout::slot, py::arg("c"), py::arg("y"), py::arg("x"))
+            .def("Size", &nn::SlotLayout::size)
+            .def("Slots", &nn::SlotLayout::slots);
+
+    py::class_<nn::Conv2DParams>(m, "Conv2DParams")
+            .def(py::init<>())
+            .def_readwrite("inChannels", &nn::Conv2DParams::inChannels)
+            .def_readwrite("outChannels", &nn::Conv2DParams::outChannels)
+            .def_readwrite("height", &nn::Conv2DParams::height)
+            .def_readwrite("width", &nn::Conv2DParams::width)
+            .def_readwrite("kernelHeight", &nn::Conv2DParams::kernelHeight)
+            .def_readwrite("kernelWidth", &nn::Conv2DParams::kernelWidth)
+            .def_readwrite("stride", &nn::Conv2DParams::stride)
+            .def_readwrite("padding", &nn::Conv2DParams::padding);
 
     py::class_<nn::Conv2D, PyImpl<nn::Conv2D>, Operator>(m, "Conv2D")
-            .def(py::init<matVec, std::vector<double>>())
+            .def(py::init<Tensor, std::vector<double>>())
+            .def(py::init<std::vector<double>, std::vector<double>, nn::Conv2DParams>(),
+                 py::arg("kernel"), py::arg("bias"), py::arg("params"))
+            .def(py::init<std::vector<double>, std::vector<double>, nn::Conv2DParams, nn::SlotLayout>(),
+                 py::arg("kernel"), py::arg("bias"), py::arg("params"), py::arg("inputLayout"))
+            .def("GetOutputLayout", &nn::Conv2D::getOutputLayout)
+            .def("GetOutputSlots", &nn::Conv2D::getOutputSlots)
             .def("__call__", initForward<nn::Conv2D>());
 
     py::class_<nn::Gemm, PyImpl<nn::Gemm>, Operator>(m, "Gemm")
-            .def(py::init<matVec, std::vector<double>>())
+            .def(py::init<Tensor, std::vector<double>>())
             .def("__call__", initForward<nn::Gemm>());
 
+    py::class_<nn::Pool2DParams>(m, "Pool2DParams")
+            .def(py::init<>())
+            .def_readwrite("channels", &nn::Pool2DParams::channels)
+            .def_readwrite("height", &nn::Pool2DParams::height)
+            .def_readwrite("width", &nn::Pool2DParams::width)
+            .def_readwrite("kernelHeight", &nn::Pool2DParams::kernelHeight)
+            .def_readwrite("kernelWidth", &nn::Pool2DParams::kernelWidth)
+            .def_readwrite("stride", &nn::Pool2DParams::stride)
+            .def_readwrite("padding", &nn::Pool2DParams::padding)
+            .def_readwrite("countIncludePad", &nn::Pool2DParams::countIncludePad);
+
     py::class_<nn::AveragePool, PyImpl<nn::AveragePool>, Operator>(m, "AveragePool")
-            .def(py::init<matVec>())
+            .def(py::init<Tensor>())
+            .def(py::init<nn::Pool2DParams>(), py::arg("params"))
+            .def(py::init<nn::Pool2DParams, nn::SlotLayout>(), py::arg("params"), py::arg("inputLayout"))
+            .def("GetOutputLayout", &nn::AveragePool::getOutputLayout)
+            .def("GetOutputSlots", &nn::AveragePool::getOutputSlots)
             .def("__call__", initForward<nn::AveragePool>());
 
+    py::class_<nn::PadParams>(m, "PadParams")
+            .def(py::init<>())
+            .def_readwrite("channels", &nn::PadParams::channels)
+            .def_readwrite("height", &nn::PadParams::height)
+            .def_readwrite("width", &nn::PadParams::width)
+            .def_readwrite("top", &nn::PadParams::top)
+            .def_readwrite("bottom", &nn::PadParams::bottom)
+            .def_readwrite("left", &nn::PadParams::left)
+            .def_readwrite("right", &nn::PadParams::right);
+
     py::class_<nn::PadOperator, PyImpl<nn::PadOperator>, Operator>(m, "PadOperator")
-            .def(py::init<matVec, std::vector<double>>())
+            .def(py::init<Tensor, std::vector<double>>())
+            .def(py::init<nn::PadParams>(), py::arg("params"))
+            .def(py::init<nn::PadParams, nn::SlotLayout>(), py::arg("params"), py::arg("inputLayout"))
+            .def("GetOutputLayout", &nn::PadOperator::getOutputLayout)
+            .def("GetOutputSlots", &nn::PadOperator::getOutputSlots)
             .def("__call__", initForward<nn::PadOperator>());
 
     py::class_<nn::BatchNorm, PyImpl<nn::BatchNorm>, Operator>(m, "BatchNorm")
@@ -233,7 +353,9 @@ void defineNeuralOFHETypes (py::module_& m) {
             .def("__call__", initForward<nn::BatchNorm>());
 
     py::class_<ActivationFunction, PythonActivation, Operator>(m, "ActivationFunction")
-            .def(py::init<double, double, uint32_t, uint32_t&, std::string>());
+            .def(py::init<double, double, uint32_t, uint32_t&, std::string>())
+            .def("GetCoefficients", &ActivationFunction::getCoefficients, ReleaseGIL())
+            .def("SetCoefficients", &ActivationFunction::setCoefficients, py::arg("coefficients"), ReleaseGIL());
 
     py::class_<nn::ReLU, ActivationFunction>(m, "ReLU")
             .def(py::init<double, double, unsigned int>())
@@ -247,6 +369,51 @@ void defineNeuralOFHETypes (py::module_& m) {
             .def(py::init<double, double, unsigned int>())
             .def("__call__", initForward<nn::Sigmoid>());
 
+    py::enum_<nn::PolynomialBasis>(m, "PolynomialBasis")
+            .value("POWER", nn::PolynomialBasis::POWER)
+            .value("CHEBYSHEV", nn::PolynomialBasis::CHEBYSHEV);
+
+    py::class_<nn::PolynomialActivation, ActivationFunction>(m, "PolynomialActivation")
+            .def(py::init<std::vector<double>, nn::PolynomialBasis, double, double>(),
+                 py::arg("coefficients"), py::arg("basis") = nn::PolynomialBasis::POWER,
+                 py::arg("min") = -1., py::arg("max") = 1.)
+            .def("GetPowerCoefficients", &nn::PolynomialActivation::getPowerCoefficients)
+            .def("__call__", initForward<nn::PolynomialActivation>());
+
+    py::class_<nn::Square, nn::PolynomialActivation>(m, "Square")
+            .def(py::init<>())
+            .def("__call__", initForward<nn::Square>());
+
+    py::class_<nn::ScaledSquare, nn::PolynomialActivation>(m, "ScaledSquare")
+            .def(py::init<double, double, double>(), py::arg("a"), py::arg("b") = 0., py::arg("c") = 0.)
+            .def("__call__", initForward<nn::ScaledSquare>());
+
+}
+
+
+/***
+ * Defines the executor for asynchronous forward passes.
+ */
+void defineAsyncExecutor (py::module_& m) {
+    py::class_<AsyncExecutor>(m, "AsyncExecutor")
+            .def(py::init<uint32_t, uint32_t>(),
+                 "Executor running at most maxInFlight forward passes at once, each with the given OpenMP threads.",
+                 py::arg("maxInFlight") = 0, py::arg("threads") = 0)
+            .def("Submit", &AsyncExecutor::submit,
+                 "Run the forward pass of an operator, returns a concurrent.futures.Future.",
+                 py::arg("operator"), py::arg("x"), py::keep_alive<0, 2>())
+            .def("SubmitModel", &AsyncExecutor::submitModel,
+                 "Run the forward passes of a list of operators, returns a concurrent.futures.Future.",
+                 py::arg("operators"), py::arg("x"), py::keep_alive<0, 2>())
+            .def("Forward", &AsyncExecutor::forward,
+                 "Awaitable forward pass of an operator, to be called from a running event loop.",
+                 py::arg("operator"), py::arg("x"), py::keep_alive<0, 2>())
+            .def("ForwardModel", &AsyncExecutor::forwardModel,
+                 "Awaitable forward pass of a list of operators, to be called from a running event loop.",
+                 py::arg("operators"), py::arg("x"), py::keep_alive<0, 2>())
+            .def("GetPending", &AsyncExecutor::getPending,
+                 "Number of submitted forward passes that have not been completed yet.")
+            .def("GetMaxInFlight", &AsyncExecutor::getMaxInFlight);
 }
 
 
@@ -1,11 +1,16 @@
 #ifndef NEURALPY_PYTHONCIPHERTEXT_H
 #define NEURALPY_PYTHONCIPHERTEXT_H
 
+#include <mutex>
+
 #include "OpenFHEPrerequisites.h"
 
 /***
  * Python-Ciphertext class which was written due to issues with long templates in
  * OpenFHE.
+ *
+ * The ciphertext pointer is read and replaced under a mutex, so the same object can be used from several Python
+ * threads.
 */
 class PythonCiphertext {
 public:
@@ -15,12 +20,20 @@ public:
     */
     PythonCiphertext () {}
 
+    PythonCiphertext (const PythonCiphertext& other) : ciphertext(other.getCiphertext()) {}
+
+    PythonCiphertext& operator= (const PythonCiphertext& other) {
+        setCiphertext(other.getCiphertext());
+        return *this;
+    }
+
     /***
      * Setter method for the underlying OpenFHE CKKS ciphertext object
      * 
      * @param cipher OpenFHE ciphertext object.
     */
     void setCiphertext(Cipher cipher) {
+        std::lock_guard<std::mutex> lock(mutex);
         ciphertext = cipher;
     }
 
@@ -29,7 +42,8 @@ public:
      * 
      * @return OpenFHE ciphertext
     */
-    Cipher getCiphertext () {
+    Cipher getCiphertext () const {
+        std::lock_guard<std::mutex> lock(mutex);
         return ciphertext;
     }
     
@@ -39,7 +53,7 @@ public:
      * @return Current ciphertext level
      */
     uint32_t GetLevel () {
-        return ciphertext->GetLevel();
+        return getCiphertext()->GetLevel();
     }
 
     /***
@@ -48,11 +62,15 @@ public:
      * @param filePath Path to Ciphertext file
      */
     void load(std::string filePath) {
-        if (!Serial::DeserializeFromFile(filePath, ciphertext, SerType::BINARY)) {
+        Cipher loaded;
+
+        if (!Serial::DeserializeFromFile(filePath, loaded, SerType::BINARY)) {
             std::cerr << "Could not deserialize " + filePath + " ciphertext" << std::endl;
             exit(1);
         } else if (Operator::getVerbosity())
             std::cout << "Ciphertext " + filePath << " deserialized." << std::endl;
+
+        setCiphertext(loaded);
     }
 
     /***
@@ -61,7 +79,7 @@ public:
      * @param filePath
      */
     void save(std::string filePath) {
-        if(!Serial::SerializeToFile(filePath, ciphertext, SerType::BINARY)) {
+        if(!Serial::SerializeToFile(filePath, getCiphertext(), SerType::BINARY)) {
             std::cerr << "Error Serializing ciphertext." << std::endl;
             exit(1);
         } else if (Operator::getVerbosity())
@@ -70,6 +88,8 @@ public:
 
 private:
     Cipher ciphertext;
+
+    mutable std::mutex mutex;
 };
 
 #endif //NEURALPY_PYTHONCIPHERTEXT_H
@@ -5,16 +5,24 @@
 #ifndef NEURALPY_PYTHONCONTEXT_H
 #define NEURALPY_PYTHONCONTEXT_H
 
+#include <shared_mutex>
+
 #include "OpenFHEPrerequisites.h"
 
 #include "PythonCiphertext.h"
 #include "PythonKeys.h"
 #include "../../NeuralOFHE/src/LinTools.h"
+#include "NeuralOFHE/Helperfunctions/HelperFunctions.h"
 
 
 /***
  *  Class around the CKKS context object. This was written do to issues with 
  *  large OpenFHE templates.
+ *
+ *  The methods can be called from several Python threads at once, the bindings release the GIL while they run.
+ *  OpenFHE keeps the evaluation keys of all contexts in static maps, so methods that replace keys lock them
+ *  exclusively, while evaluations that use them hold a shared lock, see readKeys and writeKeys. The same locks guard
+ *  the context itself, which load replaces.
 */
 class PythonContext {
 public:
@@ -29,6 +37,7 @@ public:
      * @param cont pointer to 
     */
     void SetContext(Context cont) {
+        auto lock = writeKeys();
         this->context = cont;
     }
 
@@ -47,6 +56,7 @@ public:
      * @param privateKey Mult. keys are generated from the private key
      */
     void EvalMultKeyGen (PythonKey<PrivateKey<DCRTPoly>> privateKey) {
+        auto lock = writeKeys();
         context->EvalMultKeyGen(privateKey.getKey());
     }
 
@@ -56,6 +66,7 @@ public:
      * @param privateKey private key of the circuit
      */
     void EvalBootstrapKeyGen (PythonKey<PrivateKey<DCRTPoly>> privateKey) {
+        auto lock = writeKeys();
         uint32_t slots = context->GetEncodingParams()->GetBatchSize();
 
         context->EvalBootstrapSetup(levelBudget, {0, 0}, slots);
@@ -70,6 +81,7 @@ public:
      * @return a + b
      */
     PythonCiphertext EvalAdd (PythonCiphertext a, PythonCiphertext b) {
+        auto lock = readKeys();
         PythonCiphertext result;
         Cipher ciph_result = context->EvalAdd(a.getCiphertext(), b.getCiphertext());
         result.setCiphertext(ciph_result);
@@ -85,6 +97,7 @@ public:
      * @return a + b
      */
     PythonCiphertext EvalAdd (std::vector<double> a, PythonCiphertext b) {
+        auto lock = readKeys();
         PythonCiphertext result;
         Plaintext pl = context->MakeCKKSPackedPlaintext(a);
         Cipher ciph_result = context->EvalAdd(pl, b.getCiphertext());
@@ -101,6 +114,7 @@ public:
      * @return a + b
     */
     PythonCiphertext EvalAdd (double a, PythonCiphertext b) {
+        auto lock = readKeys();
         PythonCiphertext result;
         Cipher ciph_result = context->EvalAdd(a, b.getCiphertext());
         result.setCiphertext(ciph_result);
@@ -116,6 +130,7 @@ public:
      * @return a - b
     */
     PythonCiphertext EvalSub (PythonCiphertext a, PythonCiphertext b) {
+        auto lock = readKeys();
         PythonCiphertext result;
         Cipher ciph_result = context->EvalSub(a.getCiphertext(), b.getCiphertext());
         result.setCiphertext(ciph_result);
@@ -133,6 +148,7 @@ public:
      * @return a - b if reverse is false, b - a otherwise
     */
     PythonCiphertext EvalSub (std::vector<double> a, PythonCiphertext b, bool reverse=false) {
+        auto lock = readKeys();
         PythonCiphertext result;
         Plaintext pl = context->MakeCKKSPackedPlaintext(a);
         Cipher ciph_result;
@@ -155,6 +171,7 @@ public:
      * @return a - b if reverse is false, b - a otherwise
     */
     PythonCiphertext EvalSub (double a, PythonCiphertext b, bool reverse=false) {
+        auto lock = readKeys();
         PythonCiphertext result;
         Cipher ciph_result;
         if (!reverse) {
@@ -175,6 +192,7 @@ public:
      * @return a * b
      */
     PythonCiphertext EvalMult (PythonCiphertext a, PythonCiphertext b) {
+        auto lock = readKeys();
         PythonCiphertext result;
         Cipher ciph_result = context->EvalMult(a.getCiphertext(), b.getCiphertext());
         result.setCiphertext(ciph_result);
@@ -190,6 +208,7 @@ public:
      * @return a * b
      */
     PythonCiphertext EvalMult (std::vector<double> a, PythonCiphertext b) {
+        auto lock = readKeys();
         PythonCiphertext result;
         Plaintext pl = context->MakeCKKSPackedPlaintext(a);
         Cipher ciph_result = context->EvalMult(pl, b.getCiphertext());
@@ -206,6 +225,7 @@ public:
      * @return a * b
      */
     PythonCiphertext EvalMult (double a, PythonCiphertext b) {
+        auto lock = readKeys();
         PythonCiphertext result;
         Cipher ciph_result = context->EvalMult(a, b.getCiphertext());
         result.setCiphertext(ciph_result);
@@ -220,7 +240,8 @@ public:
      * @param vec Cipher vector
      * @return vec . matrix
     */
-    PythonCiphertext EvalMatMul (matVec matrix, PythonCiphertext vec, bool parallel = true) {
+    PythonCiphertext EvalMatMul (const Tensor& matrix, PythonCiphertext vec, bool parallel = true) {
+        auto lock = readKeys();
         PythonCiphertext result;
         Cipher ciph_result = matrix_multiplication(matrix, vec.getCiphertext(), context, parallel);
         result.setCiphertext(ciph_result);
@@ -235,6 +256,7 @@ public:
      * @return bootstrapped ciphertext
      */
     PythonCiphertext EvalBootstrap (PythonCiphertext x) {
+        auto lock = readKeys();
         PythonCiphertext result;
         Ciphertext<DCRTPoly> ciph = context->EvalBootstrap(x.getCiphertext());
         result.setCiphertext(ciph);
@@ -247,16 +269,37 @@ public:
      * @param key Private key of the circuit
      */
     void GenRotations (PythonKey<PrivateKey<DCRTPoly>> key) {
+        auto lock = writeKeys();
         std::vector<int> rotations = GetRotations(context->GetEncodingParams()->GetBatchSize());
         context->EvalRotateKeyGen(key.getKey(), rotations);
     }
 
+    /***
+     * Generate only the rotation keys that the forward passes of the given operators request.
+     *
+     * @param key Private key of the circuit
+     * @param operators Operators of the model
+     */
+    void GenRotations (PythonKey<PrivateKey<DCRTPoly>> key, const std::vector<Operator*>& operators) {
+        auto lock = writeKeys();
+        std::set<int> rotations;
+
+        for (Operator* op : operators) {
+            std::vector<int> indices = op->getRotationIndices();
+            rotations.insert(indices.begin(), indices.end());
+        }
+
+        if (!rotations.empty())
+            context->EvalRotateKeyGen(key.getKey(), std::vector<int>(rotations.begin(), rotations.end()));
+    }
+
     /***
      * Get dimension of the polynomial ring within the context.
      *
      * @return Ring dimension
      */
     uint32_t GetRingDim() {
+        auto lock = readKeys();
         return context->GetRingDimension();
     }
 
@@ -268,6 +311,7 @@ public:
      * @return Encrypted ciphertext.
      */
     PythonCiphertext Encrypt(std::vector<double> plaintext, PythonKey<PublicKey<DCRTPoly>> publicKey) {
+        auto lock = readKeys();
         Plaintext pl = context->MakeCKKSPackedPlaintext(plaintext);
         uint32_t batchSize = context->GetEncodingParams()->GetBatchSize();
         PythonCiphertext result;
@@ -291,6 +335,7 @@ public:
      * @return Plaintext object resulting from the encryption.
      */
     std::vector<double> Decrypt(PythonCiphertext cipher, PythonKey<PrivateKey<DCRTPoly>> privateKey) {
+        auto lock = readKeys();
         std::vector<double> result;
         Plaintext pl;
 
@@ -310,6 +355,7 @@ public:
      * @return Keypair object
      */
     PythonKeypair KeyGen () {
+        auto lock = readKeys();
         PythonKeypair keys;
         auto keyPair = context->KeyGen();
 
@@ -329,6 +375,7 @@ public:
      * @param filePath
      */
     void load(std::string filePath) {
+        auto lock = writeKeys();
         if (!Serial::DeserializeFromFile(filePath, context, SerType::BINARY)) {
             std::cerr << "Error loading context" << std::endl;
             exit(1);
@@ -344,6 +391,7 @@ public:
      * @param filePath
      */
     void loadMultKeys(std::string filePath) {
+        auto lock = writeKeys();
         context->ClearEvalMultKeys();
 
         std::ifstream multKeyIStream(filePath, std::ios::in | std::ios::binary);
@@ -367,6 +415,7 @@ public:
      * @param filePath
      */
     void loadRotKeys (std::string filePath) {
+        auto lock = writeKeys();
         context->ClearEvalAutomorphismKeys();
 
         std::ifstream rotKeyIStream(filePath, std::ios::in | std::ios::binary);
@@ -390,6 +439,7 @@ public:
      * @param filePath
      */
     void save(std::string filePath) {
+        auto lock = readKeys();
         if (!Serial::SerializeToFile(filePath, context, SerType::BINARY)) {
             std::cerr << "Error serializing context." << std::endl;
             exit(1);
@@ -405,6 +455,7 @@ public:
      * @param filePath
      */
     void saveMultKeys(std::string filePath) {
+        auto lock = readKeys();
         std::ofstream multKeyFile(filePath, std::ios::out | std::ios::binary);
         if (multKeyFile.is_open()) {
             if (!context->SerializeEvalMultKey(multKeyFile, SerType::BINARY)) {
@@ -427,6 +478,7 @@ public:
      * @param filePath
      */
     void saveRotKeys(std::string filePath) {
+        auto lock = readKeys();
         std::ofstream rotKeyFile(filePath, std::ios::out | std::ios::binary);
         if (rotKeyFile.is_open()) {
             if (!context->SerializeEvalAutomorphismKey(rotKeyFile, SerType::BINARY)) {
@@ -444,6 +496,7 @@ public:
     }
 
     bool hasRelinKeys() {
+        auto lock = readKeys();
         auto KeyMap = this->context->GetAllEvalMultKeys();
 
         if (Operator::getVerbosity()) {
@@ -457,6 +510,7 @@ public:
     }
 
     bool hasGaloisKeys() {
+        auto lock = readKeys();
         auto KeyMap = this->context->GetAllEvalAutomorphismKeys();
 
         if (Operator::getVerbosity()) {
@@ -469,11 +523,57 @@ public:
         return KeyMap.size() != 0;
     }
 
+    /***
+     * Shared lock on the context and its evaluation keys. Only the outermost lock of a thread locks the mutex, as a
+     * Python operator within a forward pass calls methods of the context, which lock again, and a shared mutex must
+     * not be locked twice by the same thread.
+     */
+    class KeyReadLock {
+    public:
+        KeyReadLock() {
+            if (!holdsKeys) {
+                lock = std::shared_lock<std::shared_mutex>(keyMutex);
+                holdsKeys = true;
+            }
+        }
+
+        ~KeyReadLock() {
+            if (lock.owns_lock())
+                holdsKeys = false;
+        }
+
+        KeyReadLock(const KeyReadLock&) = delete;
+        KeyReadLock& operator=(const KeyReadLock&) = delete;
+
+    private:
+        std::shared_lock<std::shared_mutex> lock;
+    };
+
+    /***
+     * Shared lock on the context and its evaluation keys, held while they are used.
+     *
+     * @return Lock that is released when it goes out of scope
+     */
+    static KeyReadLock readKeys() {
+        return KeyReadLock();
+    }
+
+    /***
+     * Exclusive lock on the evaluation keys, held while they are generated, loaded or cleared. Must not be taken from
+     * a Python operator that runs within a forward pass, as that already holds the shared lock.
+     *
+     * @return Lock that is released when it goes out of scope
+     */
+    static std::unique_lock<std::shared_mutex> writeKeys() {
+        return std::unique_lock<std::shared_mutex>(keyMutex);
+    }
+
     static void setLevelBudget(std::vector<uint32_t> budget) {
         levelBudget = budget;
     }
 
     double getModulus() {
+        auto lock = readKeys();
         double result = log2(context->GetModulus().ConvertToDouble());
 
         return result;
@@ -483,8 +583,17 @@ private:
     Context context;
 
     static std::vector<uint32_t> levelBudget;
+
+    static std::shared_mutex keyMutex;
+
+    /***
+     * Whether the current thread holds a KeyReadLock.
+     */
+    static thread_local bool holdsKeys;
 };
 
 std::vector<uint32_t> PythonContext::levelBudget = {};
+std::shared_mutex PythonContext::keyMutex;
+thread_local bool PythonContext::holdsKeys = false;
 
 #endif //NEURALPY_PYTHONCONTEXT_H
@@ -41,6 +41,14 @@ public:
                 x
                 );
     }
+
+    std::vector<int> getRotationIndices() override {
+        PYBIND11_OVERRIDE(std::vector<int>, Operator, getRotationIndices);
+    }
+
+    uint32_t getDepth() override {
+        PYBIND11_OVERRIDE(uint32_t, Operator, getDepth);
+    }
 };
 
 /***
@@ -55,6 +63,14 @@ public:
     Ciphertext<DCRTPoly> forward (Ciphertext<DCRTPoly> x) override {
         PYBIND11_OVERRIDE(Ciphertext<DCRTPoly>, Impl, forward, x);
     }
+
+    std::vector<int> getRotationIndices() override {
+        PYBIND11_OVERRIDE(std::vector<int>, Impl, getRotationIndices);
+    }
+
+    uint32_t getDepth() override {
+        PYBIND11_OVERRIDE(uint32_t, Impl, getDepth);
+    }
 };
 
 /***
@@ -74,6 +90,10 @@ public:
         );
     }
 
+    uint32_t getDepth() override {
+        PYBIND11_OVERRIDE(uint32_t, ActivationFunction, getDepth);
+    }
+
     const std::function<double (double)> &getFunc() override {
         PYBIND11_OVERRIDE_PURE(
                 std::function<double (double)>,
@@ -11,9 +11,15 @@
 #ifndef NEURALPY_WRAPPERFUNCTIONS_H
 #define NEURALPY_WRAPPERFUNCTIONS_H
 
+#include <pybind11/numpy.h>
+
 #include "WrapperClasses.h"
 #include "NeuralOFHE/NeuralOFHE.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 
 /***
  * Python function to set the context variable.
@@ -63,6 +69,100 @@ void SetVerbosity(bool verbose) {
     Operator::setVerbosity(verbose);
 }
 
+/***
+ * Setting the number of OpenMP threads the operators use when called from the current thread. Python threads that run
+ * forward passes concurrently should share the cores, e.g. each one calling this with cores / threads.
+ *
+ * @param threads Number of OpenMP threads
+ */
+void SetNumThreads(int threads) {
+    #ifdef _OPENMP
+    omp_set_num_threads(threads);
+    #endif
+}
+
+/***
+ * Enabling or disabling the per-layer profiling of all operators.
+ *
+ * @param enabled
+ */
+void SetProfiling(bool enabled) {
+    Profiler::setEnabled(enabled);
+}
+
+/***
+ * Formats the profiles of operators as a table with one row per operator.
+ *
+ * @param operators Operators in the order of the forward pass
+ * @return Table
+ */
+std::string ProfileReport(const std::vector<Operator*>& operators) {
+    std::vector<LayerProfile> profiles;
+    for (Operator* op : operators)
+        profiles.push_back(op->getProfile());
+
+    return Profiler::report(profiles);
+}
+
+/***
+ * Enabling or disabling the tracer. Enabling it clears the spans and histograms of the last trace.
+ *
+ * @param enabled
+ */
+void SetTracing(bool enabled) {
+    if (enabled)
+        Tracer::start();
+    else
+        Tracer::stop();
+}
+
+/***
+ * Writing the spans of the last trace as Chrome trace JSON, which can be opened in chrome://tracing or Perfetto.
+ *
+ * @param filePath Path of the JSON file
+ */
+void WriteTrace(std::string filePath) {
+    Tracer::write(filePath);
+}
+
+/***
+ * Latency histograms of the last trace per layer type, formatted as a table.
+ *
+ * @return Table
+ */
+std::string LatencyReport() {
+    return Tracer::histogramReport();
+}
+
+/***
+ * Converts a profile into a dictionary.
+ *
+ * @param profile
+ * @return Dictionary with one entry per field of the profile
+ */
+pybind11::dict LayerProfileToDict(const LayerProfile& profile) {
+    pybind11::dict result;
+
+    result["name"] = profile.name;
+    result["calls"] = profile.calls;
+    result["seconds"] = profile.seconds;
+    result["fastRotations"] = profile.fastRotations;
+    result["rotations"] = profile.rotations;
+    result["plainMults"] = profile.plainMults;
+    result["cipherMults"] = profile.cipherMults;
+    result["scalarMults"] = profile.scalarMults;
+    result["rescales"] = profile.rescales;
+    result["encodes"] = profile.encodes;
+    result["keySwitches"] = profile.keySwitches;
+    result["bootstraps"] = profile.bootstraps;
+    result["inputLevel"] = profile.inputLevel;
+    result["outputLevel"] = profile.outputLevel;
+    result["inputBytes"] = profile.inputBytes;
+    result["outputBytes"] = profile.outputBytes;
+
+    return result;
+}
+
 /***
  * Calculating mulitplication Depth required for bootstrapping
  *
@@ -74,4 +174,50 @@ uint32_t GetBootStrapDepth(uint32_t approxDepth,std::vector<uint32_t> levelBudge
 }
 
 
+/***
+ * Numpy array type that is accepted for tensors. Arrays of another type or memory order are converted by pybind11,
+ * which is the only case in which the values are copied.
+ */
+using TensorArray = pybind11::array_t<double, pybind11::array::c_style | pybind11::array::forcecast>;
+
+
+/***
+ * Wraps a numpy array into a tensor without copying its values. The tensor holds a reference to the array, which is
+ * released with the GIL held once the last tensor that refers to the array is destroyed, possibly from a thread that
+ * does not hold the GIL.
+ *
+ * @param array C-contiguous array of doubles
+ * @return Tensor on the memory of the array
+ */
+Tensor TensorFromArray(TensorArray array) {
+    std::vector<size_t> shape(array.shape(), array.shape() + array.ndim());
+
+    auto* keepAlive = new TensorArray(std::move(array));
+    std::shared_ptr<const double> data(keepAlive->data(), [keepAlive](const double*) {
+        pybind11::gil_scoped_acquire gil;
+        delete keepAlive;
+    });
+
+    return Tensor(std::move(shape), std::move(data));
+}
+
+
+/***
+ * Buffer description of a tensor, so that numpy can view it without a copy.
+ *
+ * @param tensor Tensor that should be viewed
+ * @return Read-only buffer of the tensor
+ */
+pybind11::buffer_info TensorBuffer(Tensor& tensor) {
+    std::vector<pybind11::ssize_t> shape(tensor.shape().begin(), tensor.shape().end());
+    std::vector<pybind11::ssize_t> strides(shape.size(), sizeof(double));
+
+    for (int i = (int) shape.size() - 2; i >= 0; i--)
+        strides[i] = strides[i + 1] * shape[i + 1];
+
+    return pybind11::buffer_info(const_cast<double*>(tensor.data()), sizeof(double),
+                                 pybind11::format_descriptor<double>::format(), shape.size(), shape, strides, true);
+}
+
+
 #endif //NEURALPY_WRAPPERFUNCTIONS_H
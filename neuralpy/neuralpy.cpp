@@ -12,10 +12,20 @@ PYBIND11_MODULE(neuralpy, m) {
     defineEnums(m);
     defineBasicOpenFHEModules(m);
     defineNeuralOFHETypes(m);
+    defineAsyncExecutor(m);
     m.def("SetContext", &SetPythonContext, py::arg("context"));
     m.def("MakeContext", &MakeContext, py::arg("parameters"));
     m.def("GetContext", &GetContext, py::arg("ciphertext"));
     m.def("SetVerbosity", &SetVerbosity, py::arg("verbose"));
+    m.def("SetNumThreads", &SetNumThreads, py::arg("threads"));
+    m.def("SetProfiling", &SetProfiling, py::arg("enabled"));
+    m.def("ProfileReport", &ProfileReport, py::arg("operators"));
+    m.def("SetTracing", &SetTracing, py::arg("enabled"));
+    m.def("WriteTrace", &WriteTrace, py::arg("filePath"), py::call_guard<py::gil_scoped_release>());
+    m.def("LatencyReport", &LatencyReport);
+    m.def("LoadNpy", &LoadNpy, py::arg("filePath"), py::call_guard<py::gil_scoped_release>());
+    m.def("SetPlaintextCacheBudget", &SetPlaintextCacheBudget, py::arg("bytes"));
+    m.def("SetDoubleHoisting", &SetDoubleHoisting, py::arg("enabled"));
     m.def("GetBootstrapDepth", &GetBootStrapDepth, 
           py::arg("approx_depth"), py::arg("level_budget"), py::arg("secret_key_dist"));
 }